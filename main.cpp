@@ -1,4 +1,7 @@
 #include <vector>
+#include <algorithm>
+#include <string_view>
+#include <optional>
 #include <random>
 #include <glad/glad.h>
 #include <math.h>
@@ -18,7 +21,18 @@
 #include "gl_debug.h"
 
 // #include "triangulate.h"
+#include "async_reconstruction.h"
 #include "bpa.h"
+#include "camera_path.h"
+#include "chunked.h"
+#include "decimate.h"
+#include "frame_timer.h"
+#include "frustum.h"
+#include "lights.h"
+#include "lod.h"
+#include "mesh_cache.h"
+#include "point_renderer.h"
+#include "tunnel.h"
 
 #include <iostream>
 
@@ -69,14 +83,69 @@ std::vector<Point> genRandomPointCloud(std::size_t numPoints) {
   return out;
 }
 
-int main() {
-  Window window{ SCREEN_WIDTH, SCREEN_HEIGHT };
+// Tunnel wall sampled like a static scan: dense around the station at z = 0 and thinning out along the tunnel, so the
+// points per grid cell vary widely.
+std::vector<Point> genSkewedCloud(std::size_t numPoints) {
+  std::vector<Point> out{};
+
+  std::random_device rd{};
+  std::mt19937 engine{ rd() };
+
+  std::uniform_real_distribution<double> distAngle{ 0.0, 2 * std::numbers::pi };
+  std::uniform_real_distribution<double> distLength{ -4.0, 4.0 };
+  std::exponential_distribution<double> distFalloff{ 1.5 };
+  std::bernoulli_distribution distSide{ 0.5 };
+
+  double radius = 2.0;
+
+  for (std::size_t i = 0; i < numPoints; ++i) {
+	auto theta = distAngle(engine);
+	// half the points cover the whole tunnel, the other half pile up around the station
+	auto z = i % 2 ? distLength(engine) : std::min(distFalloff(engine), 4.0) * (distSide(engine) ? 1 : -1);
+
+	glm::vec3 pos{ radius * std::cos(theta), radius * std::sin(theta), z };
+	out.emplace_back(pos, glm::normalize(glm::vec3{ -pos.x, -pos.y, 0.0f }));
+  }
+
+  return out;
+}
+
+int main(int argc, char** argv) {
+  // With --headless, renders a scripted flight through the tunnel into an offscreen target, without a visible window,
+  // and reports the frame times, for benchmarks in CI and on compute nodes.
+  const auto headless = std::find(argv + 1, argv + argc, std::string_view{ "--headless" }) != argv + argc;
+  constexpr std::size_t benchmarkFrames = 600;
+
+  Window window{ SCREEN_WIDTH, SCREEN_HEIGHT, !headless };
+  auto& camera = window.camera;
 
   Renderer renderer{ window, camera };
   renderer.setupContext();
 
+  std::optional<OffscreenTarget> offscreen;
+  if (headless) {
+	offscreen = createOffscreenTarget();
+	if (!offscreen)
+	  return 1;
+	// frames are not held back by the display
+	glfwSwapInterval(0);
+  }
+  const CameraPath benchmarkPath{ {
+	{ { 1.0f, 1.0f, -3.0f }, 90.0f, 0.0f },
+	{ { 1.0f, 1.0f, 4.5f }, 90.0f, 0.0f },
+	{ { 1.0f, 1.0f, 4.5f }, 270.0f, -10.0f },
+	{ { 1.0f, 1.0f, -3.0f }, 270.0f, 0.0f },
+	{ { 1.0f, 1.0f, 10.0f }, 270.0f, 0.0f },
+  } };
+  FrameTimer timer;
+
   Shader shader("res/shaders/basic.vs.glsl", "res/shaders/basic.fs.glsl");
   Shader lightShader("res/shaders/light_box.vs.glsl", "res/shaders/light_box.fs.glsl");
+  Shader splatShader("res/shaders/splat.vs.glsl", "res/shaders/splat.fs.glsl");
+  Shader gizmoShader("res/shaders/gizmo.vs.glsl", "res/shaders/gizmo.fs.glsl");
+  Shader gBufferShader("res/shaders/basic.vs.glsl", "res/shaders/gbuffer.fs.glsl");
+  Shader directionalShader("res/shaders/deferred.vs.glsl", "res/shaders/deferred_dir.fs.glsl");
+  Shader lightVolumeShader("res/shaders/light_volume.vs.glsl", "res/shaders/light_volume.fs.glsl");
 
   std::size_t numPoints = 20000;
 
@@ -87,21 +156,175 @@ int main() {
 	glm::vec3(0.0f, 0.0f, -3.0f)
   };
 
+  // the lights only change here, they are uploaded once instead of set every frame
+  LightBlock lights{};
+  lights.dirLight.direction = { -0.2f, -1.0f, -0.3f };
+  lights.dirLight.ambient = { 0.6f, 0.05f, 0.05f };
+  lights.dirLight.diffuse = glm::vec3{ 0.4f };
+  lights.dirLight.specular = glm::vec3{ 0.5f };
+  for (auto i = 0; i < pointLightCount; ++i) {
+	auto& light = lights.pointLights[i];
+	light.position = pointLightPositions[i];
+	light.ambient = glm::vec3{ 0.05f };
+	light.diffuse = glm::vec3{ 0.8f };
+	light.specular = glm::vec3{ 1.0f };
+	light.constant = 1.0f;
+	light.linear = 0.09f;
+	light.quadratic = 0.032f;
+  }
+  lights.shininess = 32.0f;
+  LightUniforms lightUniforms;
+  lightUniforms.update(lights);
+  shader.bindBlock("LightBlock", LightUniforms::binding);
+  splatShader.bindBlock("LightBlock", LightUniforms::binding);
+  directionalShader.bindBlock("LightBlock", LightUniforms::binding);
+  lightVolumeShader.bindBlock("LightBlock", LightUniforms::binding);
+
   glm::vec3 color{ 1.0f, 1.0f, 1.0f };
   lightShader.use();
   lightShader.setVec3("lightColor", color);
 
+  // compares the grid with the k-d tree on a cloud of uneven density before starting
+  constexpr auto benchmarkIndex = false;
+  if (benchmarkIndex)
+	benchmarkSpatialIndex(genSkewedCloud(numPoints * 10), 0.095f);
+
   // Gen cloud
   auto cloud = genRandomPointCloud(numPoints);
   // auto cloud = genSphericalCloud(200, 100);
 
+  // reconstructs the cloud in the deterministic mode on 1, 2 and 4 threads and reports if the meshes differ
+  constexpr auto checkDeterministic = false;
+  if (checkDeterministic)
+	checkDeterminism(cloud, 0.095f);
+  // reconstructs several independent scans at once, one per worker thread
+  constexpr auto benchmarkScans = false;
+  if (benchmarkScans) {
+	std::vector<std::vector<Point>> scans;
+	for (int i = 0; i < 8; i++)
+	  scans.push_back(genRandomPointCloud(numPoints));
+	measuredReconstructAll(scans, 0.095f);
+  }
+
   // Triangulate
   /*
 	auto triangulation = DelaunayTriangulation();
 	auto mesh = triangulation.GetTriangulationResult(cloud);
 	std::cout << triangulation.GetStatistics() << '\n';
   */
-  auto mesh = measuredReconstruct(cloud, 0.095f);
+  // The mesh comes from the cache when the cloud was reconstructed with the same radius before. Otherwise it is
+  // reconstructed on a worker thread and drawn while it grows, and once complete it is cached and handed to the display
+  // paths below like a cached one. R reconstructs again with the ball radius scaled by [ and ].
+  constexpr auto asyncReconstruction = true;
+  constexpr auto ballRadius = 0.095f;
+  // tunnel scans can skip ball pivoting and be triangulated unrolled around their axis
+  constexpr auto tunnelMode = false;
+  // the cloud is reconstructed as a scan arriving in batches, each insert only extending the mesh around its points
+  constexpr auto incrementalScan = false;
+  // dense scans are decimated for display, 0 keeps every triangle
+  constexpr std::size_t displayTriangles = 0;
+  // the mesh is drawn with shared vertices and smooth normals instead of three vertices per triangle
+  constexpr auto indexedDrawing = true;
+  // long tunnels are drawn as tiles along the axis, coarser with distance and only those in view
+  constexpr auto tiledRendering = false;
+  // the cloud and the mesh are cut into chunks and only the chunks in view are drawn
+  constexpr auto cullChunks = false;
+
+  ReconstructionCache cache{ "cache/reconstruction", 4ull << 30 };
+  AsyncReconstruction reconstruction;
+  std::vector<Triangle> batch;
+  // radius of the mesh being reconstructed or shown
+  auto meshRadius = ballRadius;
+
+  // the complete mesh and what the display paths make of it, unused while the mesh is still streamed in
+  std::vector<Triangle> mesh;
+  IndexedMesh indexedMesh;
+  std::optional<LodMesh> lod;
+  std::optional<Chunked<Triangle>> chunkedMesh;
+  auto meshComplete = false;
+  const auto showMesh = [&](std::vector<Triangle> complete) {
+	mesh = std::move(complete);
+	if (displayTriangles > 0)
+	  mesh = toTriangles(measuredDecimate(indexMesh(mesh), { displayTriangles }));
+	if (indexedDrawing) {
+	  renderer.releaseMesh(indexedMesh);
+	  indexedMesh = indexMesh(mesh);
+	}
+	if (tiledRendering) {
+	  renderer.releaseTiles();
+	  lod.emplace(mesh, fitTunnelAxis(cloud));
+	}
+	if (cullChunks) {
+	  if (chunkedMesh)
+		renderer.releaseChunks(chunkedMesh->id());
+	  chunkedMesh.emplace(mesh, 0.5f);
+	}
+	renderer.clearStreamed();
+	meshComplete = true;
+  };
+  const auto reconstructMesh = [&](float radius) {
+	meshRadius = radius;
+	meshComplete = false;
+	renderer.clearStreamed();
+	if (tunnelMode)
+	  showMesh(measuredReconstructTunnel(cloud));
+	else if (incrementalScan) {
+	  // the scanner advances along the tunnel, so each batch covers new wall at full density
+	  auto sweep = cloud;
+	  std::sort(begin(sweep), end(sweep), [](const Point& a, const Point& b) { return a.pos.z < b.pos.z; });
+	  showMesh(measuredReconstructIncremental(sweep, radius, numPoints / 10));
+	}
+	else if (!asyncReconstruction)
+	  showMesh(cachedReconstruct(cache, cloud, radius));
+	else if (auto cached = loadReconstruction(cache, cloud, radius))
+	  showMesh(std::move(*cached));
+	else
+	  reconstruction.start(cloud, radius);
+  };
+  // streams the new batches in and takes over the mesh once the worker is done
+  const auto pollReconstruction = [&] {
+	while (reconstruction.poll(batch))
+	  renderer.appendStreamed(batch);
+	if (auto result = reconstruction.takeResult()) {
+	  cache.store(reconstructionKey(cloud, meshRadius), *result);
+	  showMesh(std::move(*result));
+	}
+  };
+
+  reconstructMesh(ballRadius);
+  // benchmarks time the finished mesh
+  while (headless && reconstruction.running()) {
+	pollReconstruction();
+	std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+  // the batches queued after the last poll and the finished mesh
+  pollReconstruction();
+
+  // where the scanner stood, the generated clouds are scanned from the origin
+  const std::vector<glm::vec3> scanStations{ glm::vec3{ 0.0f } };
+
+  // The mesh is lit in a deferred pass, each point light only over the pixels it reaches. Besides the scene lights the
+  // tunnel gets a row of lamps under the ceiling.
+  constexpr auto deferredShading = false;
+  constexpr auto lampSpacing = 0.25f;
+  std::vector<LightVolume> lightVolumes;
+  for (auto pos : pointLightPositions)
+	lightVolumes.push_back(makeLightVolume(pos, glm::vec3{ 1.0f }, 0.09f, 0.032f));
+  for (auto z = -4.0f; z <= 4.0f; z += lampSpacing) {
+	const auto lamp = glm::vec3(Renderer::meshTransform() * glm::vec4(0.0f, 1.6f, z, 1.0f));
+	lightVolumes.push_back(makeLightVolume(lamp, { 1.0f, 0.85f, 0.6f }, 1.0f, 12.0f));
+  }
+
+  std::optional<Chunked<Point>> chunkedCloud;
+  if (cullChunks)
+	chunkedCloud.emplace(cloud, 0.5f);
+
+  // the cloud is uploaded once and drawn as splats when it is not cut into chunks
+  PointRenderer points;
+  if (!cullChunks) {
+	points.splatRadius = 0.095f * 0.5f;
+	points.upload(cloud);
+  }
 
   shader.use();
 
@@ -112,6 +335,15 @@ int main() {
 	deltaTime = currentFrame - lastFrame;
 	lastFrame = currentFrame;
 
+	if (headless) {
+	  if (timer.frameCount() == benchmarkFrames)
+		break;
+	  benchmarkPath.apply(camera, static_cast<float>(timer.frameCount()) / static_cast<float>(benchmarkFrames - 1));
+	  glBindFramebuffer(GL_FRAMEBUFFER, offscreen->framebuffer);
+	  glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+	  timer.begin();
+	}
+
 	/*
 	if (window.refresh) {
 	  window.refresh = false;
@@ -121,6 +353,15 @@ int main() {
 	}
 	*/
 
+	if (asyncReconstruction) {
+	  if (window.refresh) {
+		window.refresh = false;
+		std::cout << "Reconstructing with radius " << ballRadius * window.radiusScale << '\n';
+		reconstructMesh(ballRadius * window.radiusScale);
+	  }
+	  pollReconstruction();
+	}
+
 	renderer.update();
 
 	glClearColor(0.1f, 0.1f, 0.1f, 1.0f);
@@ -128,43 +369,6 @@ int main() {
 
 	shader.use();
 	shader.setVec3("viewPos", camera.Position);
-	shader.setFloat("material.shininess", 32.0f);
-	shader.setVec3("dirLight.direction", -0.2f, -1.0f, -0.3f);
-	shader.setVec3("dirLight.ambient", 0.6f, 0.05f, 0.05f);
-	shader.setVec3("dirLight.diffuse", 0.4f, 0.4f, 0.4f);
-	shader.setVec3("dirLight.specular", 0.5f, 0.5f, 0.5f);
-	// point light 1
-	shader.setVec3("pointLights[0].position", pointLightPositions[0]);
-	shader.setVec3("pointLights[0].ambient", 0.05f, 0.05f, 0.05f);
-	shader.setVec3("pointLights[0].diffuse", 0.8f, 0.8f, 0.8f);
-	shader.setVec3("pointLights[0].specular", 1.0f, 1.0f, 1.0f);
-	shader.setFloat("pointLights[0].constant", 1.0f);
-	shader.setFloat("pointLights[0].linear", 0.09f);
-	shader.setFloat("pointLights[0].quadratic", 0.032f);
-	// point light 2
-	shader.setVec3("pointLights[1].position", pointLightPositions[1]);
-	shader.setVec3("pointLights[1].ambient", 0.05f, 0.05f, 0.05f);
-	shader.setVec3("pointLights[1].diffuse", 0.8f, 0.8f, 0.8f);
-	shader.setVec3("pointLights[1].specular", 1.0f, 1.0f, 1.0f);
-	shader.setFloat("pointLights[1].constant", 1.0f);
-	shader.setFloat("pointLights[1].linear", 0.09f);
-	shader.setFloat("pointLights[1].quadratic", 0.032f);
-	// point light 3
-	shader.setVec3("pointLights[2].position", pointLightPositions[2]);
-	shader.setVec3("pointLights[2].ambient", 0.05f, 0.05f, 0.05f);
-	shader.setVec3("pointLights[2].diffuse", 0.8f, 0.8f, 0.8f);
-	shader.setVec3("pointLights[2].specular", 1.0f, 1.0f, 1.0f);
-	shader.setFloat("pointLights[2].constant", 1.0f);
-	shader.setFloat("pointLights[2].linear", 0.09f);
-	shader.setFloat("pointLights[2].quadratic", 0.032f);
-	// point light 4
-	shader.setVec3("pointLights[3].position", pointLightPositions[3]);
-	shader.setVec3("pointLights[3].ambient", 0.05f, 0.05f, 0.05f);
-	shader.setVec3("pointLights[3].diffuse", 0.8f, 0.8f, 0.8f);
-	shader.setVec3("pointLights[3].specular", 1.0f, 1.0f, 1.0f);
-	shader.setFloat("pointLights[3].constant", 1.0f);
-	shader.setFloat("pointLights[3].linear", 0.09f);
-	shader.setFloat("pointLights[3].quadratic", 0.032f);
 
 	window.processInput(camera, deltaTime);
 
@@ -172,33 +376,75 @@ int main() {
 
 	glm::mat4 projection = glm::perspective(glm::radians(camera.Zoom), static_cast<float>(SCREEN_WIDTH) / static_cast<float>(SCREEN_HEIGHT), 0.1f, 100.0f);
 	glm::mat4 view = camera.GetViewMatrix();
-	shader.use();
-	shader.setMat4("projection", projection);
-	shader.setMat4("view", view);
+	// the deferred path draws the mesh into the G-buffer and lights it afterwards
+	auto& meshShader = deferredShading ? gBufferShader : shader;
+	meshShader.use();
+	meshShader.setMat4("projection", projection);
+	meshShader.setMat4("view", view);
+	if (deferredShading)
+	  renderer.beginGeometryPass();
+
+	// culling and selection happen in mesh space
+	const auto model = Renderer::meshTransform();
+	const Frustum frustum{ projection * view * model };
 
 	if (window.renderMesh) {
-	  renderer.renderMesh(shader, mesh);
+	  if (!meshComplete)
+		renderer.renderStreamed(meshShader);
+	  else if (lod) {
+		const auto eye = glm::vec3(glm::inverse(model) * glm::vec4(camera.Position, 1.0f));
+		renderer.renderTiles(meshShader, *lod, lod->select(eye, projection * view * model));
+	  } else if (chunkedMesh)
+		renderer.renderMesh(meshShader, *chunkedMesh, frustum);
+	  else if (indexedDrawing)
+		renderer.renderMesh(meshShader, indexedMesh);
+	  else
+		renderer.renderMesh(meshShader, mesh);
 	}
 
+	if (deferredShading)
+	  renderer.lightingPass(directionalShader, lightVolumeShader, lightVolumes, projection, view, camera.Position, headless ? offscreen->framebuffer : 0);
+
 	lightShader.use();
 	lightShader.setMat4("projection", projection);
 	lightShader.setMat4("view", view);
 
+	// light boxes and scan stations in one draw
 	if (window.renderLights) {
-	  for (auto pos : pointLightPositions) {
-		renderer.renderCube(lightShader, pos);
-	  }
+	  std::vector<Gizmo> gizmos;
+	  for (auto pos : pointLightPositions)
+		gizmos.push_back({ pos, 0.15f, color });
+	  for (auto station : scanStations)
+		gizmos.push_back({ glm::vec3(model * glm::vec4(station, 1.0f)), 0.1f, { 0.1f, 0.8f, 0.2f } });
+	  gizmoShader.use();
+	  gizmoShader.setMat4("projection", projection);
+	  gizmoShader.setMat4("view", view);
+	  renderer.renderGizmos(gizmoShader, gizmos);
 	}
 
 	if (window.renderPoints) {
-	  renderer.renderPoints(lightShader, cloud);
+	  if (chunkedCloud)
+		renderer.renderPoints(lightShader, *chunkedCloud, frustum);
+	  else {
+		splatShader.use();
+		splatShader.setMat4("projection", projection);
+		splatShader.setMat4("view", view);
+		splatShader.setMat4("model", model);
+		splatShader.setVec3("viewPos", camera.Position);
+		points.render(splatShader, static_cast<float>(renderer.height()), window.previewPoints);
+	  }
 	}
 
+	if (headless)
+	  timer.end();
 
 	glfwSwapBuffers(window.handle());
 	glfwPollEvents();
   }
 
+  if (headless)
+	timer.report(std::cout);
+
   glfwTerminate();
   return 0;
 }
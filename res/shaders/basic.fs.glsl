@@ -13,15 +13,14 @@ struct DirLight {
     vec3 specular;
 };
 
+// the scalars fill the padding after the vec3s, LightBlock in lights.h mirrors this layout
 struct PointLight {
     vec3 position;
-    
     float constant;
-    float linear;
-    float quadratic;
-	
     vec3 ambient;
+    float linear;
     vec3 diffuse;
+    float quadratic;
     vec3 specular;
 };
 
@@ -31,9 +30,13 @@ in vec3 WorldPos;
 in vec3 Normal;
 
 uniform vec3 viewPos;
-uniform DirLight dirLight;
-uniform PointLight pointLights[NR_POINT_LIGHTS];
-uniform Material material;
+
+// written by the application only when the lights change
+layout (std140) uniform LightBlock {
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+    Material material;
+};
 
 // function prototypes
 vec3 CalcDirLight(DirLight light, vec3 normal, vec3 viewDir);
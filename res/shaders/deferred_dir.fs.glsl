@@ -0,0 +1,57 @@
+#version 330 core
+out vec4 FragColor;
+
+struct Material {
+    float shininess;
+}; 
+
+struct DirLight {
+    vec3 direction;
+	
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+};
+
+#define NR_POINT_LIGHTS 4
+
+in vec2 TexCoords;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+uniform vec3 viewPos;
+
+// same block as basic.fs.glsl, only the directional light and the material are used here
+layout (std140) uniform LightBlock {
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+    Material material;
+};
+
+void main() {
+    vec4 position = texture(gPosition, TexCoords);
+    // no surface, the background stays
+    if (position.a == 0.0)
+        discard;
+    vec3 normal = texture(gNormal, TexCoords).rgb;
+    vec4 albedoSpec = texture(gAlbedoSpec, TexCoords);
+    vec3 viewDir = normalize(viewPos - position.xyz);
+
+    vec3 lightDir = normalize(-dirLight.direction);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    vec3 result = albedoSpec.rgb * (dirLight.ambient + dirLight.diffuse * diff) + dirLight.specular * spec * albedoSpec.a;
+    FragColor = vec4(result, 1.0);
+}
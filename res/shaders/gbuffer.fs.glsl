@@ -0,0 +1,15 @@
+#version 330 core
+layout (location = 0) out vec4 gPosition;
+layout (location = 1) out vec4 gNormal;
+layout (location = 2) out vec4 gAlbedoSpec;
+
+in vec3 WorldPos;
+in vec3 Normal;
+
+void main() {
+    // alpha marks the pixels that have a surface
+    gPosition = vec4(WorldPos, 1.0);
+    gNormal = vec4(normalize(Normal), 0.0);
+    // the mesh has no material, white and fully specular as in basic.fs.glsl
+    gAlbedoSpec = vec4(1.0);
+}
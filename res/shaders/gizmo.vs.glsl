@@ -0,0 +1,16 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+// per instance
+layout (location = 3) in vec4 aPlacement;
+layout (location = 4) in vec3 aColor;
+
+out vec3 Color;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main()
+{
+    Color = aColor;
+    gl_Position = projection * view * vec4(aPlacement.xyz + aPos * aPlacement.w, 1.0);
+}
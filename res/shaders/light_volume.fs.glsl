@@ -0,0 +1,66 @@
+#version 330 core
+out vec4 FragColor;
+
+struct Material {
+    float shininess;
+}; 
+
+struct DirLight {
+    vec3 direction;
+	
+    vec3 ambient;
+    vec3 diffuse;
+    vec3 specular;
+};
+
+struct PointLight {
+    vec3 position;
+    float constant;
+    vec3 ambient;
+    float linear;
+    vec3 diffuse;
+    float quadratic;
+    vec3 specular;
+};
+
+#define NR_POINT_LIGHTS 4
+
+flat in vec4 Light;
+flat in vec3 Color;
+flat in vec2 Attenuation;
+
+uniform sampler2D gPosition;
+uniform sampler2D gNormal;
+uniform sampler2D gAlbedoSpec;
+uniform vec3 viewPos;
+uniform vec2 screenSize;
+
+// same block as basic.fs.glsl, only the material is used here
+layout (std140) uniform LightBlock {
+    DirLight dirLight;
+    PointLight pointLights[NR_POINT_LIGHTS];
+    Material material;
+};
+
+void main() {
+    vec2 uv = gl_FragCoord.xy / screenSize;
+    vec4 position = texture(gPosition, uv);
+    if (position.a == 0.0)
+        discard;
+    vec3 toLight = Light.xyz - position.xyz;
+    float distance = length(toLight);
+    if (distance > Light.w)
+        discard;
+
+    vec3 normal = texture(gNormal, uv).rgb;
+    vec4 albedoSpec = texture(gAlbedoSpec, uv);
+    vec3 lightDir = toLight / distance;
+    vec3 viewDir = normalize(viewPos - position.xyz);
+    float diff = max(dot(normal, lightDir), 0.0);
+    vec3 reflectDir = reflect(-lightDir, normal);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), material.shininess);
+    float attenuation = 1.0 / (1.0 + Attenuation.x * distance + Attenuation.y * (distance * distance));
+    // same proportions as the forward point lights: ambient 0.05, diffuse 0.8 and specular 1 of the color
+    vec3 result = albedoSpec.rgb * Color * (0.05 + 0.8 * diff) + Color * spec * albedoSpec.a;
+    FragColor = vec4(result * attenuation, 1.0);
+}
@@ -0,0 +1,21 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+// per light: position and radius, color, linear and quadratic attenuation
+layout (location = 3) in vec4 aLight;
+layout (location = 4) in vec3 aColor;
+layout (location = 5) in vec2 aAttenuation;
+
+flat out vec4 Light;
+flat out vec3 Color;
+flat out vec2 Attenuation;
+
+uniform mat4 projection;
+uniform mat4 view;
+
+void main() {
+    Light = aLight;
+    Color = aColor;
+    Attenuation = aAttenuation;
+    // the unit cube scaled to enclose the sphere of the light
+    gl_Position = projection * view * vec4(aLight.xyz + aPos * aLight.w, 1.0);
+}
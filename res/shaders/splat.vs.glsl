@@ -0,0 +1,24 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec4 aNormal;
+
+out vec3 WorldPos;
+out vec3 Normal;
+out vec3 ViewNormal;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+uniform float splatRadius;
+uniform float viewportHeight;
+
+void main() {
+    WorldPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(model) * aNormal.xyz;
+    ViewNormal = mat3(view) * Normal;
+
+    gl_Position = projection * view * vec4(WorldPos, 1.0);
+    // diameter in pixels of the splat at this depth
+    gl_PointSize = max(splatRadius * projection[1][1] * viewportHeight / gl_Position.w, 1.0);
+}
@@ -1,11 +1,23 @@
-#include <iostream>
-#include <glm/glm.h>
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#if defined(__SSE__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 1)
+#include <xmmintrin.h>
+#define AABB_SSE 1
+#endif
 
 class AABB {
 public:
   AABB(glm::vec3 max, glm::vec3 min): vecMax{max}, vecMin{min} {}
 
-  bool overlap(const AABB& tBox2) {
+  bool overlap(const AABB& tBox2) const {
       return(vecMax.x > tBox2.vecMin.x &&
 	     vecMin.x < tBox2.vecMax.x &&
 	     vecMax.y > tBox2.vecMin.y &&
@@ -14,7 +26,99 @@ public:
 	     vecMin.z < tBox2.vecMax.z);
   }
 
+  void extend(const AABB& box) {
+    vecMax = glm::max(vecMax, box.vecMax);
+    vecMin = glm::min(vecMin, box.vecMin);
+  }
+
+  glm::vec3 center() const { return (vecMax + vecMin) * 0.5f; }
+  glm::vec3 extent() const { return (vecMax - vecMin) * 0.5f; }
+  const glm::vec3& upper() const { return vecMax; }
+  const glm::vec3& lower() const { return vecMin; }
+
+  // Plane as (normal, distance) with the inside where dot(normal, p) + distance >= 0. The box is outside when even its
+  // corner furthest along the normal is behind the plane.
+  bool outside(const glm::vec4& plane) const {
+    const glm::vec3 normal{ plane };
+    return glm::dot(normal, center()) + plane.w < -glm::dot(glm::abs(normal), extent());
+  }
+
+  // Conservative like any plane-by-plane test, a box next to a corner of the frustum can pass without touching it.
+  bool intersects(const std::array<glm::vec4, 6>& frustum) const {
+    for (const auto& plane : frustum)
+      if (outside(plane)) return false;
+    return true;
+  }
+
 private:
   glm::vec3 vecMax;
   glm::vec3 vecMin;
 };
+
+// Many boxes as center and half extent in separate arrays, so the frustum test runs on four boxes per instruction.
+class AABBBatch {
+public:
+  void push_back(const AABB& box) {
+    const auto c = box.center();
+    const auto e = box.extent();
+    centerX.push_back(c.x);
+    centerY.push_back(c.y);
+    centerZ.push_back(c.z);
+    extentX.push_back(e.x);
+    extentY.push_back(e.y);
+    extentZ.push_back(e.z);
+  }
+
+  std::size_t size() const { return centerX.size(); }
+
+  // replaces the contents of visible with the indices of the boxes that intersect the frustum, in ascending order
+  void cull(const std::array<glm::vec4, 6>& frustum, std::vector<std::uint32_t>& visible) const {
+    visible.clear();
+    std::size_t i = 0;
+#ifdef AABB_SSE
+    struct Splat {
+      __m128 x, y, z, w, absX, absY, absZ;
+    };
+    std::array<Splat, 6> planes;
+    for (std::size_t p = 0; p < planes.size(); p++) {
+      const auto& plane = frustum[p];
+      planes[p] = { _mm_set1_ps(plane.x), _mm_set1_ps(plane.y), _mm_set1_ps(plane.z), _mm_set1_ps(plane.w),
+                    _mm_set1_ps(std::abs(plane.x)), _mm_set1_ps(std::abs(plane.y)), _mm_set1_ps(std::abs(plane.z)) };
+    }
+    for (; i + 4 <= size(); i += 4) {
+      const auto cx = _mm_loadu_ps(&centerX[i]);
+      const auto cy = _mm_loadu_ps(&centerY[i]);
+      const auto cz = _mm_loadu_ps(&centerZ[i]);
+      const auto ex = _mm_loadu_ps(&extentX[i]);
+      const auto ey = _mm_loadu_ps(&extentY[i]);
+      const auto ez = _mm_loadu_ps(&extentZ[i]);
+      auto outside = _mm_setzero_ps();
+      for (const auto& plane : planes) {
+        const auto distance = _mm_add_ps(_mm_add_ps(_mm_mul_ps(cx, plane.x), _mm_mul_ps(cy, plane.y)), _mm_add_ps(_mm_mul_ps(cz, plane.z), plane.w));
+        const auto radius = _mm_add_ps(_mm_add_ps(_mm_mul_ps(ex, plane.absX), _mm_mul_ps(ey, plane.absY)), _mm_mul_ps(ez, plane.absZ));
+        outside = _mm_or_ps(outside, _mm_cmplt_ps(_mm_add_ps(distance, radius), _mm_setzero_ps()));
+        // most boxes of a large scene are behind the camera or off to a side, the remaining planes cannot bring them back
+        if (_mm_movemask_ps(outside) == 0xf) break;
+      }
+      auto inside = static_cast<unsigned>(~_mm_movemask_ps(outside) & 0xf);
+      for (; inside != 0; inside &= inside - 1)
+        visible.push_back(static_cast<std::uint32_t>(i + static_cast<std::size_t>(std::countr_zero(inside))));
+    }
+#endif
+    // same operation order as above, so a box gets the same answer whichever path tests it
+    for (; i < size(); i++) {
+      auto outside = false;
+      for (const auto& plane : frustum) {
+        const auto distance = (centerX[i] * plane.x + centerY[i] * plane.y) + (centerZ[i] * plane.z + plane.w);
+        const auto radius = (extentX[i] * std::abs(plane.x) + extentY[i] * std::abs(plane.y)) + extentZ[i] * std::abs(plane.z);
+        outside = outside || distance + radius < 0;
+      }
+      if (!outside)
+        visible.push_back(static_cast<std::uint32_t>(i));
+    }
+  }
+
+private:
+  std::vector<float> centerX, centerY, centerZ;
+  std::vector<float> extentX, extentY, extentZ;
+};
@@ -0,0 +1,77 @@
+#include "async_reconstruction.h"
+
+#include <chrono>
+#include <iostream>
+#include <utility>
+
+AsyncReconstruction::~AsyncReconstruction() {
+  cancel();
+}
+
+void AsyncReconstruction::start(std::span<const Point> points, float radius, const ReconstructionOptions& options) {
+  cancel();
+  // the worker is joined, this thread is the only one left using the queue
+  std::vector<Triangle> stale;
+  while (batches.pop(stale)) {
+  }
+  result.reset();
+
+  finished = false;
+  worker = std::jthread([this, points, radius, options](std::stop_token stop) {
+	const auto start = std::chrono::high_resolution_clock::now();
+	std::size_t published = 0;
+
+	ReconstructionContext context;
+	context.progress = [&](std::span<const IndexedTriangle> faces) {
+	  std::vector<Triangle> batch;
+	  batch.reserve(faces.size());
+	  for (const auto& f : faces)
+		batch.push_back({ points[f[0]].pos, points[f[1]].pos, points[f[2]].pos });
+	  published += batch.size();
+	  // the render loop drains the queue every frame, a full queue only waits for the next one
+	  while (!batches.push(std::move(batch))) {
+		if (stop.stop_requested())
+		  return false;
+		std::this_thread::yield();
+	  }
+	  return !stop.stop_requested();
+	};
+	const auto faces = reconstructIndexed(context, points, radius, options);
+	if (!stop.stop_requested()) {
+	  std::vector<Triangle> triangles;
+	  triangles.reserve(faces.size());
+	  for (const auto& f : faces)
+		triangles.push_back({ points[f[0]].pos, points[f[1]].pos, points[f[2]].pos });
+	  if (options.deterministic)
+		canonicalize(triangles);
+	  result = std::move(triangles);
+	}
+
+	const auto end = std::chrono::high_resolution_clock::now();
+	const auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+	std::cerr << "[  ASYNC   ] Point: " << points.size() << " Triangles: " << published << (stop.stop_requested() ? " cancelled" : "") << " after " << seconds << "s\n";
+	finished = true;
+  });
+}
+
+void AsyncReconstruction::cancel() {
+  if (worker.joinable()) {
+	worker.request_stop();
+	worker.join();
+  }
+  finished = true;
+}
+
+bool AsyncReconstruction::poll(std::vector<Triangle>& batch) {
+  return batches.pop(batch);
+}
+
+bool AsyncReconstruction::running() const {
+  return !finished;
+}
+
+std::optional<std::vector<Triangle>> AsyncReconstruction::takeResult() {
+  if (!finished)
+	return {};
+  return std::exchange(result, std::nullopt);
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include "bpa.h"
+#include "spsc_queue.h"
+
+// Runs reconstruct on a worker thread and hands the triangles over in batches as the front advances, so the viewer can
+// draw the mesh while it grows instead of waiting for the whole reconstruction.
+class AsyncReconstruction {
+ public:
+  AsyncReconstruction() = default;
+  // cancels a running job
+  ~AsyncReconstruction();
+
+  AsyncReconstruction(const AsyncReconstruction&) = delete;
+  AsyncReconstruction& operator=(const AsyncReconstruction&) = delete;
+
+  // Cancels the running job, if any, drops the batches it left in the queue and starts over. The points are used in
+  // place and have to stay alive and unchanged until the job is done or cancelled.
+  void start(std::span<const Point> points, float radius, const ReconstructionOptions& options = {});
+  void cancel();
+
+  // Takes the next published batch, only from the thread that calls start. Returns false when there is none yet.
+  bool poll(std::vector<Triangle>& batch);
+  // true until the worker has published its last batch or was cancelled
+  bool running() const;
+  // The whole mesh as reconstruct returns it, once the job finished without being cancelled. Only from the thread that
+  // calls start, and only once per job.
+  std::optional<std::vector<Triangle>> takeResult();
+
+ private:
+  SpscQueue<std::vector<Triangle>> batches{ 64 };
+  std::jthread worker;
+  // written by the worker before it sets finished
+  std::optional<std::vector<Triangle>> result;
+  std::atomic<bool> finished{ true };
+};
@@ -2,6 +2,10 @@
 
 #include <chrono>
 #include <algorithm>
+#include <atomic>
+#include <bit>
+#include <functional>
+#include <limits>
 #include <tuple>
 #include <deque>
 #include <optional>
@@ -10,21 +14,26 @@
 #include <sstream>
 #include <numeric>
 #include <numbers>
+#include <unordered_map>
+
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_sort.h>
+#include <tbb/task_arena.h>
 
 #include <glm/gtx/io.hpp>
 
+#include "hash.h"
+#include "hole_filling.h"
+#include "kd_tree.h"
+#include "parallel.h"
+#include "radix_sort.h"
+#include "spatial_index.h"
+
 using namespace glm;
 
 constexpr auto debug = false;
 
-struct MeshEdge;
-
-struct MeshPoint {
-  vec3 pos;
-  vec3 normal;
-  bool used = false;
-  std::vector<MeshEdge*> edges;
-};
+constexpr auto noSlot = std::numeric_limits<std::uint32_t>::max();
 
 enum class EdgeStatus {
   active,
@@ -33,56 +42,327 @@ enum class EdgeStatus {
 };
 
 struct MeshEdge {
-  MeshPoint* a;
-  MeshPoint* b;
-  MeshPoint* opposite;
+  PointId a;
+  PointId b;
+  PointId opposite;
   vec3 center;
   MeshEdge* prev;
   MeshEdge* next;
   EdgeStatus status = EdgeStatus::active;
 };
 
-struct MeshFace : std::array<MeshPoint*, 3> {
-  auto normal() const {
-	return normalize(cross((*this)[0]->pos - (*this)[1]->pos, (*this)[0]->pos - (*this)[2]->pos));
-  }
+using MeshFace = IndexedTriangle;
+
+// 10 bytes instead of the 24 of a Point: the position as 16-bit fixed point offsets from the origin of the point's
+// cell and the normal octahedral-encoded in two 16-bit components. Only 16-bit members, so arrays of it need no padding.
+struct QuantizedPoint {
+  std::array<std::uint16_t, 3> offset;
+  std::array<std::uint16_t, 2> normal;
 };
 
-using Cell = std::vector<MeshPoint>;
+static_assert(sizeof(QuantizedPoint) == 10);
+
+constexpr auto quantizationSteps = 65535.0f;
+
+std::uint32_t encodeNormal(vec3 n) {
+  const auto l1 = std::abs(n.x) + std::abs(n.y) + std::abs(n.z);
+  if (l1 == 0.0f)
+	return encodeNormal({ 0, 0, 1 });
+  auto x = n.x / l1;
+  auto y = n.y / l1;
+  if (n.z < 0) {
+	const auto foldedX = (1 - std::abs(y)) * (x < 0 ? -1.0f : 1.0f);
+	const auto foldedY = (1 - std::abs(x)) * (y < 0 ? -1.0f : 1.0f);
+	x = foldedX;
+	y = foldedY;
+  }
+  const auto snorm = [](float v) { return static_cast<std::uint16_t>(static_cast<std::int16_t>(std::round(std::clamp(v, -1.0f, 1.0f) * 32767.0f))); };
+  return static_cast<std::uint32_t>(snorm(x)) | static_cast<std::uint32_t>(snorm(y)) << 16;
+}
+
+vec3 decodeNormal(std::uint32_t encoded) {
+  const auto x = static_cast<float>(static_cast<std::int16_t>(encoded & 0xffff)) / 32767.0f;
+  const auto y = static_cast<float>(static_cast<std::int16_t>(encoded >> 16)) / 32767.0f;
+  vec3 n{ x, y, 1 - std::abs(x) - std::abs(y) };
+  if (n.z < 0) {
+	n.x = (1 - std::abs(y)) * (x < 0 ? -1.0f : 1.0f);
+	n.y = (1 - std::abs(x)) * (y < 0 ? -1.0f : 1.0f);
+  }
+  return normalize(n);
+}
+
+// cells per axis a Morton code can tell apart
+constexpr int mortonAxisCells = 1 << 21;
 
+// Morton code of a cell, 21 bits per axis interleaved. Indices from mortonAxisCells on would collide.
+std::uint64_t mortonCode(ivec3 index) {
+  const auto spread = [](std::uint64_t v) {
+	v &= 0x1fffff;
+	v = (v | v << 32) & 0x1f00000000ffffull;
+	v = (v | v << 16) & 0x1f0000ff0000ffull;
+	v = (v | v << 8) & 0x100f00f00f00f00full;
+	v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+	v = (v | v << 2) & 0x1249249249249249ull;
+	return v;
+  };
+  return spread(static_cast<std::uint64_t>(index.x)) | spread(static_cast<std::uint64_t>(index.y)) << 1 | spread(static_cast<std::uint64_t>(index.z)) << 2;
+}
+
+// points per task when building the grid
+constexpr std::size_t buildGrain = 1 << 14;
+
+// source of Grid::generation, unique across all grids so cached blocks of an earlier grid never match
+std::atomic<std::uint64_t> gridGenerations{ 0 };
+
+struct CellRange {
+  std::uint32_t begin;
+  std::uint32_t end;
+};
+
+// order holds the point ids sorted by cell and every cell is a range of it. Cells are laid out row-major by default;
+// in Morton mode they follow the Z-order curve, so the 27 cells of a neighborhood sit close together in memory, and the
+// points are also copied into that order so the scan reads them sequentially. Ids always stay the caller's indices.
+//
+// In quantized mode the grid also keeps a QuantizedPoint per entry of order, and the neighborhood query decodes those
+// instead of reading the full points. Everything the reconstruction sees is then the quantized cloud, only the output
+// triangles use the original positions. With Morton order that needs no copy of the points.
 struct Grid {
-  Grid(const std::vector<Point>& points, float radius)
-	: cellSize(radius * 2) {
-	lower = points.front().pos;
-	upper = points.front().pos;
+  Grid(std::span<const Point> input, float radius, const ReconstructionOptions& options)
+	: points(input), cellSize(radius * 2), quantized(options.quantized), morton(options.mortonOrder) {
+	using Bounds = std::pair<vec3, vec3>;
+	std::tie(lower, upper) = parallelReduce(
+	  input.size(), buildGrain, false, Bounds{ input.front().pos, input.front().pos },
+	  [&](std::size_t from, std::size_t to, Bounds bounds) {
+		for (auto i = from; i < to; i++) {
+		  for (auto axis = 0; axis < 3; axis++) {
+			bounds.first[axis] = std::min(bounds.first[axis], input[i].pos[axis]);
+			bounds.second[axis] = std::max(bounds.second[axis], input[i].pos[axis]);
+		  }
+		}
+		return bounds;
+	  },
+	  [](Bounds a, const Bounds& b) {
+		for (auto axis = 0; axis < 3; axis++) {
+		  a.first[axis] = std::min(a.first[axis], b.first[axis]);
+		  a.second[axis] = std::max(a.second[axis], b.second[axis]);
+		}
+		return a;
+	  });
+
+	rebuildCells();
+  }
+
+  // Takes the points again after more were appended to them and returns the linear indices of the cells that received
+  // new points. The new points are appended to their cells, in slots after the sorted ones, so an insert costs in
+  // proportion to the new points. The cells are only sorted again once the appended slots outnumber the sorted ones, or
+  // when a point lies outside the bounds. That grows the grid by at least half its extent on that side, so a scan
+  // appended along the tunnel changes the cell layout only a logarithmic number of times.
+  auto insert(std::span<const Point> all) -> std::vector<std::size_t> {
+	const auto firstNew = points.size();
+	points = all;
+
+	auto newLower = lower;
+	auto newUpper = upper;
+	for (auto i = firstNew; i < points.size(); i++) {
+	  newLower = min(newLower, points[i].pos);
+	  newUpper = max(newUpper, points[i].pos);
+	}
 
-	for (const auto& p : points) {
+	if (newLower != lower || newUpper != upper) {
+	  const auto extent = upper - lower;
 	  for (auto i = 0; i < 3; i++) {
-		lower[i] = std::min(lower[i], p.pos[i]);
-		upper[i] = std::max(upper[i], p.pos[i]);
+		if (newLower[i] < lower[i])
+		  newLower[i] = std::min(newLower[i], lower[i] - extent[i] / 2);
+		if (newUpper[i] > upper[i])
+		  newUpper[i] = std::max(newUpper[i], upper[i] + extent[i] / 2);
 	  }
+	  lower = newLower;
+	  upper = newUpper;
+	  rebuildCells();
+	} else if (order.size() - sortedCount + (points.size() - firstNew) > sortedCount) {
+	  rebuildCells();
+	} else {
+	  for (auto i = firstNew; i < points.size(); i++)
+		append(static_cast<PointId>(i));
+	  // the cached blocks may miss the new points
+	  generation = ++gridGenerations;
 	}
 
+	std::vector<std::size_t> touched;
+	for (auto i = firstNew; i < points.size(); i++)
+	  touched.push_back(linearIndex(cellIndex(points[i].pos)));
+	std::sort(begin(touched), end(touched));
+	touched.erase(std::unique(begin(touched), end(touched)), end(touched));
+	return touched;
+  }
+
+  // both sorts are stable, so every cell keeps the input order
+  void rebuildCells() {
+	generation = ++gridGenerations;
 	dims = max(ivec3{ ceil((upper - lower) / cellSize) }, ivec3{ 1 });
+	cells.assign(static_cast<std::size_t>(dims.x * dims.y * dims.z), {});
+	// grids too long for the Morton codes keep the row-major order
+	if (morton && std::max({ dims.x, dims.y, dims.z }) <= mortonAxisCells)
+	  sortByMortonCode();
+	else
+	  sortByCell();
+	sortedCount = order.size();
+	appended.clear();
 
-	cells.resize(dims.x * dims.y * dims.z);
-	for (const auto& p : points)
-	  cell(cellIndex(p.pos)).push_back({ p.pos, p.normal });
+	packed.clear();
+	slotOf.clear();
+	sorted.clear();
+	if (quantized) {
+	  packed.resize(points.size());
+	  slotOf.resize(points.size());
+	  parallelFor(order.size(), buildGrain, false, [&](std::size_t from, std::size_t to) {
+		for (auto slot = from; slot < to; slot++) {
+		  const auto& p = points[order[slot]];
+		  packed[slot] = quantize(p, cellOrigin(cellIndex(p.pos)));
+		  slotOf[order[slot]] = static_cast<std::uint32_t>(slot);
+		}
+	  });
+	} else if (morton) {
+	  sorted.assign(points.size(), Point{ vec3{}, vec3{} });
+	  parallelFor(order.size(), buildGrain, false, [&](std::size_t from, std::size_t to) {
+		for (auto slot = from; slot < to; slot++)
+		  sorted[slot] = points[order[slot]];
+	  });
+	}
   }
 
-  auto cellIndex(vec3 point) -> ivec3 {
+  // a point in the next free slot, listed with its cell until the next rebuild
+  void append(PointId id) {
+	const auto& p = points[id];
+	const auto index = cellIndex(p.pos);
+	const auto slot = static_cast<std::uint32_t>(order.size());
+	order.push_back(id);
+	if (quantized) {
+	  packed.push_back(quantize(p, cellOrigin(index)));
+	  slotOf.push_back(slot);
+	} else if (morton)
+	  sorted.push_back(p);
+	appended[linearIndex(index)].push_back(slot);
+  }
+
+  // visits the slots of a cell, the sorted ones first and then those appended since
+  template <typename F>
+  void forEachSlot(std::size_t linear, F&& f) const {
+	const auto range = cells[linear];
+	for (auto slot = range.begin; slot < range.end; slot++)
+	  f(slot);
+	if (appended.empty())
+	  return;
+	const auto it = appended.find(linear);
+	if (it != appended.end())
+	  for (const auto slot : it->second)
+		f(slot);
+  }
+
+  // counting sort, row-major cell order
+  // Counts and scatters in parallel with atomic per-cell counters. The scatter leaves each cell in arbitrary order, so
+  // the cells are sorted by id afterwards, which is exactly the order a serial pass produces.
+  void sortByCell() {
+	const auto n = points.size();
+	std::vector<std::uint32_t> cellOf(n);
+	parallelFor(n, buildGrain, false, [&](std::size_t from, std::size_t to) {
+	  for (auto i = from; i < to; i++) {
+		cellOf[i] = static_cast<std::uint32_t>(linearIndex(cellIndex(points[i].pos)));
+		std::atomic_ref{ cells[cellOf[i]].end }.fetch_add(1, std::memory_order_relaxed);
+	  }
+	});
+
+	std::uint32_t offset = 0;
+	for (auto& c : cells) {
+	  const auto count = c.end;
+	  c = { offset, offset };
+	  offset += count;
+	}
+
+	order.resize(n);
+	parallelFor(n, buildGrain, false, [&](std::size_t from, std::size_t to) {
+	  for (auto i = from; i < to; i++)
+		order[std::atomic_ref{ cells[cellOf[i]].end }.fetch_add(1, std::memory_order_relaxed)] = static_cast<PointId>(i);
+	});
+	parallelFor(cells.size(), buildGrain, false, [&](std::size_t from, std::size_t to) {
+	  for (auto c = from; c < to; c++)
+		std::sort(order.begin() + cells[c].begin, order.begin() + cells[c].end);
+	});
+  }
+
+  void sortByMortonCode() {
+	std::vector<std::uint64_t> keys(points.size());
+	order.resize(points.size());
+	parallelFor(points.size(), 1 << 14, true, [&](std::size_t from, std::size_t to) {
+	  for (auto i = from; i < to; i++) {
+		keys[i] = mortonCode(cellIndex(points[i].pos));
+		order[i] = static_cast<PointId>(i);
+	  }
+	});
+	const auto maxDim = static_cast<unsigned>(std::max({ dims.x, dims.y, dims.z }));
+	parallelRadixSort(keys, order, 3 * std::bit_width(maxDim - 1));
+
+	CellRange* current = nullptr;
+	for (std::size_t slot = 0; slot < order.size(); slot++) {
+	  if (slot == 0 || keys[slot] != keys[slot - 1]) {
+		current = &cells[linearIndex(cellIndex(points[order[slot]].pos))];
+		current->begin = static_cast<std::uint32_t>(slot);
+		current->end = current->begin;
+	  }
+	  current->end++;
+	}
+  }
+
+  auto cellOrigin(ivec3 index) const -> vec3 {
+	return lower + vec3{ index } * cellSize;
+  }
+
+  auto quantize(const Point& p, vec3 origin) const -> QuantizedPoint {
+	const auto offset = clamp(round((p.pos - origin) / cellSize * quantizationSteps), vec3{ 0 }, vec3{ quantizationSteps });
+	const auto normal = encodeNormal(p.normal);
+	return { { static_cast<std::uint16_t>(offset.x), static_cast<std::uint16_t>(offset.y), static_cast<std::uint16_t>(offset.z) }, { static_cast<std::uint16_t>(normal), static_cast<std::uint16_t>(normal >> 16) } };
+  }
+
+  static auto decodeNormal(const QuantizedPoint& q) -> vec3 {
+	return ::decodeNormal(static_cast<std::uint32_t>(q.normal[0]) | static_cast<std::uint32_t>(q.normal[1]) << 16);
+  }
+
+  auto decodePosition(const QuantizedPoint& q, vec3 origin) const -> vec3 {
+	return origin + vec3{ q.offset[0], q.offset[1], q.offset[2] } * (cellSize / quantizationSteps);
+  }
+
+  auto cellIndex(vec3 point) const -> ivec3 {
 	const auto index = ivec3{ (point - lower) / cellSize };
 	return clamp(index, ivec3{}, dims - 1);
   }
 
-  auto cell(ivec3 index) -> Cell& {
-	return cells[index.z * dims.x * dims.y + index.y * dims.x + index.x];
+  auto linearIndex(ivec3 index) const -> std::size_t {
+	return static_cast<std::size_t>(index.z * dims.x * dims.y + index.y * dims.x + index.x);
+  }
+
+  auto cellIndex(std::size_t linear) const -> ivec3 {
+	const auto i = static_cast<int>(linear);
+	return { i % dims.x, (i / dims.x) % dims.y, i / (dims.x * dims.y) };
+  }
+
+  auto cellCount() const -> std::size_t {
+	return cells.size();
   }
 
-  auto sphericalNeighborhood(vec3 point, std::initializer_list<vec3> ignore) -> std::vector<MeshPoint*> {
-	std::vector<MeshPoint*> result;
-	const auto centerIndex = cellIndex(point);
-	result.reserve(cell(centerIndex).size() * 27);// just an estimate
+  // position and normal as the reconstruction sees them, decoded from the stored quantized copy in quantized mode
+  auto pos(PointId p) const -> vec3 {
+	if (!quantized)
+	  return points[p].pos;
+	return decodePosition(packed[slotOf[p]], cellOrigin(cellIndex(points[p].pos)));
+  }
+
+  auto normal(PointId p) const -> vec3 {
+	return quantized ? decodeNormal(packed[slotOf[p]]) : points[p].normal;
+  }
+
+  // every point of the 27 cells around the cell, decoded
+  void gatherBlock(ivec3 centerIndex, std::vector<Neighbor>& result) const {
+	result.clear();
 	for (auto xOff : { -1, 0, 1 }) {
 	  for (auto yOff : { -1, 0, 1 }) {
 		for (auto zOff : { -1, 0, 1 }) {
@@ -90,39 +370,191 @@ struct Grid {
 		  if (index.x < 0 || index.x >= dims.x) continue;
 		  if (index.y < 0 || index.y >= dims.y) continue;
 		  if (index.z < 0 || index.z >= dims.z) continue;
-		  for (auto& p : cell(index))
-			if (length2(p.pos - point) < cellSize * cellSize && std::find(begin(ignore), end(ignore), p.pos) == end(ignore))
-			  result.push_back(&p);
+		  const auto origin = cellOrigin(index);
+		  forEachSlot(linearIndex(index), [&](std::uint32_t slot) {
+			if (quantized)
+			  result.push_back({ decodePosition(packed[slot], origin), decodeNormal(packed[slot]), order[slot] });
+			else if (morton)
+			  result.push_back({ sorted[slot].pos, sorted[slot].normal, order[slot] });
+			else
+			  result.push_back({ points[order[slot]].pos, points[order[slot]].normal, order[slot] });
+		  });
 		}
 	  }
 	}
-	return result;
   }
 
+  std::span<const Point> points;
   vec3 lower;
   vec3 upper;
   float cellSize;
   ivec3 dims;
-  std::vector<Cell> cells;
+  std::vector<PointId> order;
+  std::vector<CellRange> cells;
+  // slots [0, sortedCount) of order are sorted by cell, the rest were appended since and are listed here by cell
+  std::size_t sortedCount = 0;
+  std::unordered_map<std::size_t, std::vector<std::uint32_t>> appended;
+  bool quantized;
+  bool morton;
+  std::vector<QuantizedPoint> packed;
+  // slot of every point in packed, so single points are decoded from the stored copy as well
+  std::vector<std::uint32_t> slotOf;
+  std::vector<Point> sorted;
+  // changes with every rebuild of the cells
+  std::uint64_t generation = 0;
 };
 
-std::optional<vec3> computeBallCenter(MeshFace f, float radius) {
-  const vec3 ac = f[2]->pos - f[0]->pos;
-  const vec3 ab = f[1]->pos - f[0]->pos;
+struct EdgeSlot {
+  MeshEdge* edge;
+  std::uint32_t next;
+};
+
+// Mutable per-point state, kept in compact arrays next to the grid instead of in every point: one bit for whether the
+// point is part of the mesh, and the head of a list of its incident edges that lives in one shared slot array.
+struct PointState {
+  void resize(std::size_t count) {
+	usedBits.resize((count + 63) / 64);
+	firstEdge.resize(count, noSlot);
+  }
+
+  bool used(PointId p) const {
+	return (usedBits[p / 64] >> (p % 64)) & 1;
+  }
+
+  void markUsed(PointId p) {
+	usedBits[p / 64] |= std::uint64_t{ 1 } << (p % 64);
+  }
+
+  void addEdge(PointId p, MeshEdge* e) {
+	edgeSlots.push_back({ e, firstEdge[p] });
+	firstEdge[p] = static_cast<std::uint32_t>(edgeSlots.size() - 1);
+  }
+
+  // visits the edges of p, most recently added first
+  template <typename F>
+  void forEachEdge(PointId p, F&& f) const {
+	for (auto slot = firstEdge[p]; slot != noSlot; slot = edgeSlots[slot].next)
+	  f(edgeSlots[slot].edge);
+  }
+
+  std::vector<std::uint64_t> usedBits;
+  std::vector<std::uint32_t> firstEdge;
+  std::vector<EdgeSlot> edgeSlots;
+};
+
+// Gathered neighborhoods of the last few queried grid cells. Consecutive pivots walk along the front and mostly query
+// the same cell, so they filter the cached block by distance instead of gathering the 27 cells again. The points never
+// move, only a rebuild of the grid invalidates the entries, through its generation.
+struct BlockCache {
+  struct Entry {
+	std::uint64_t generation = 0;
+	std::size_t cell = 0;
+	std::vector<Neighbor> points;
+  };
+  std::array<Entry, 8> entries;
+};
+
+// The grid as a SpatialIndex, answering queries from the block cache. Radius queries scan the 27 cells around the
+// center, so the radius must not exceed the cell size.
+struct GridIndex : SpatialIndex {
+  GridIndex(const Grid& g, BlockCache& b)
+	: grid(g), blocks(b) {}
+
+  void radiusQuery(vec3 center, float radius, std::initializer_list<vec3> ignore, std::vector<Neighbor>& result) const override {
+	const auto index = grid.cellIndex(center);
+	const auto cell = grid.linearIndex(index);
+	auto& entry = blocks.entries[cell % blocks.entries.size()];
+	if (entry.generation != grid.generation || entry.cell != cell) {
+	  grid.gatherBlock(index, entry.points);
+	  entry.generation = grid.generation;
+	  entry.cell = cell;
+	}
+	result.clear();
+	for (const auto& p : entry.points) {
+	  if (withinRadius(p.pos, center, radius) && std::find(begin(ignore), end(ignore), p.pos) == end(ignore))
+		result.push_back(p);
+	}
+  }
+
+  const Grid& grid;
+  BlockCache& blocks;
+};
+
+struct ReconstructionContext::Scratch {
+  std::vector<Neighbor> neighborhood;
+  BlockCache blocks;
+  // lower bound of the pivot angle and index into the neighborhood
+  std::vector<std::pair<float, std::uint32_t>> candidates;
+  std::stringstream log;
+};
+
+ReconstructionContext::ReconstructionContext()
+  : scratch{ std::make_unique<Scratch>() } {}
+
+ReconstructionContext::~ReconstructionContext() = default;
+ReconstructionContext::ReconstructionContext(ReconstructionContext&&) noexcept = default;
+ReconstructionContext& ReconstructionContext::operator=(ReconstructionContext&&) noexcept = default;
+
+struct ReconstructionState {
+  ReconstructionState(ReconstructionContext& c, std::span<const Point> points, float r, const ReconstructionOptions& options)
+	: context(c), grid(points, r, options), radius(r), useKdTree(options.index == SpatialIndexType::kdTree),
+	  gridIndex(grid, c.scratch->blocks), index(useKdTree ? static_cast<const SpatialIndex&>(tree) : gridIndex) {
+	state.resize(points.size());
+	if (useKdTree)
+	  extendIndex(0);
+  }
+
+  // Neighborhood query of the pivot and the seed search, radius is the cell size. The grid stays in use for the seed
+  // order and the boundary bookkeeping even with the tree.
+  void neighborhood(vec3 center, std::initializer_list<vec3> ignore, std::vector<Neighbor>& result) const {
+	index.radiusQuery(center, grid.cellSize, ignore, result);
+  }
+
+  // adds the points from firstNew on to the tree
+  void extendIndex(std::size_t firstNew) {
+	tree.insert(static_cast<PointId>(firstNew), static_cast<PointId>(grid.points.size()), [&](PointId p) { return grid.pos(p); }, [&](PointId p) { return grid.normal(p); });
+  }
+
+  ReconstructionContext& context;
+  Grid grid;
+  PointState state;
+  float radius;
+  bool useKdTree;
+  KdForest tree;
+  GridIndex gridIndex;
+  // the index chosen by the options, queried through the interface
+  const SpatialIndex& index;
+  std::vector<MeshFace> faces;
+  // faces already passed to context.progress
+  std::size_t reported = 0;
+  bool cancelled = false;
+  std::deque<MeshEdge> edges;
+  std::vector<MeshEdge*> front;
+  // boundary edges by the grid cell of their midpoint, which is the center of their pivot neighborhood
+  std::unordered_map<std::size_t, std::vector<MeshEdge*>> boundary;
+};
+
+vec3 faceNormal(vec3 a, vec3 b, vec3 c) {
+  return normalize(cross(a - b, a - c));
+}
+
+std::optional<vec3> computeBallCenter(vec3 a, vec3 b, vec3 c, float radius) {
+  const vec3 ac = c - a;
+  const vec3 ab = b - a;
   const vec3 abXac = cross(ab, ac);
   const vec3 toCircumCircleCenter = (cross(abXac, ab) * dot(ac, ac) + cross(ac, abXac) * dot(ab, ab)) / (2 * dot(abXac, abXac));
-  const vec3 circumCircleCenter = f[0]->pos + toCircumCircleCenter;
+  const vec3 circumCircleCenter = a + toCircumCircleCenter;
 
   const auto heightSquared = radius * radius - dot(toCircumCircleCenter, toCircumCircleCenter);
   if (heightSquared < 0)
 	return {};
-  auto ballCenter = circumCircleCenter + f.normal() * std::sqrt(heightSquared);
+  auto ballCenter = circumCircleCenter + faceNormal(a, b, c) * std::sqrt(heightSquared);
   return ballCenter;
 }
 
-bool ballIsEmpty(vec3 ballCenter, const std::vector<MeshPoint*>& points, float radius) {
-  return !std::any_of(begin(points), end(points), [&](MeshPoint* p) {
-	return length2(p->pos - ballCenter) < radius * radius - 1e-4f;// TODO epsilon
+bool ballIsEmpty(vec3 ballCenter, const std::vector<Neighbor>& points, float radius) {
+  return !std::any_of(begin(points), end(points), [&](const Neighbor& p) {
+	return length2(p.pos - ballCenter) < radius * radius - 1e-4f;// TODO epsilon
   });
 }
 
@@ -131,30 +563,38 @@ struct SeedResult {
   vec3 ballCenter;
 };
 
-std::optional<SeedResult> findSeedTriangle(Grid& grid, float radius) {
-  for (auto& cell : grid.cells) {
-	const auto avgNormal = normalize(std::accumulate(begin(cell), end(cell), vec3{}, [](vec3 acc, const MeshPoint& p) {
-	  return acc + p.normal;
-	}));
-	for (auto& p1 : cell) {
-	  auto neighborhood = grid.sphericalNeighborhood(p1.pos, { p1.pos });
-	  std::sort(begin(neighborhood), end(neighborhood), [&](MeshPoint* a, MeshPoint* b) {
-		return length(a->pos - p1.pos) < length(b->pos - p1.pos);
-	  });
+vec3 averageNormal(const Grid& grid, std::size_t cellIndex) {
+  vec3 sum{};
+  grid.forEachSlot(cellIndex, [&](std::uint32_t slot) {
+	sum += grid.normal(grid.order[slot]);
+  });
+  return normalize(sum);
+}
 
-	  for (auto& p2 : neighborhood) {
-		for (auto& p3 : neighborhood) {
-		  if (p2 == p3) continue;
-		  MeshFace f{ { &p1, p2, p3 } };
-		  if (dot(f.normal(), avgNormal) < 0)// only accept triangles which's normal points into the same half-space as the average normal of this cell's points
-			continue;
-		  const auto ballCenter = computeBallCenter(f, radius);
-		  if (ballCenter && ballIsEmpty(ballCenter.value(), neighborhood, radius)) {
-			p1.used = true;
-			p2->used = true;
-			p3->used = true;
-			return SeedResult{ f, ballCenter.value() };
-		  }
+// tries the candidates in order, avgNormal is that of their cell
+std::optional<SeedResult> findSeedTriangle(ReconstructionState& r, std::span<const PointId> candidates, vec3 avgNormal) {
+  const auto& grid = r.grid;
+  for (const auto p1 : candidates) {
+	if (r.state.used(p1)) continue;
+	const auto p1Pos = grid.pos(p1);
+	auto& neighborhood = r.context.scratch->neighborhood;
+	r.neighborhood(p1Pos, { p1Pos }, neighborhood);
+	std::sort(begin(neighborhood), end(neighborhood), [&](const Neighbor& a, const Neighbor& b) {
+	  return length(a.pos - p1Pos) < length(b.pos - p1Pos);
+	});
+
+	for (const auto& p2 : neighborhood) {
+	  for (const auto& p3 : neighborhood) {
+		if (p2.id == p3.id || r.state.used(p2.id) || r.state.used(p3.id)) continue;
+		if (dot(faceNormal(p1Pos, p2.pos, p3.pos), avgNormal) < 0)// only accept triangles which's normal points into the same half-space as the average normal of this cell's points
+		  continue;
+		const auto ballCenter = computeBallCenter(p1Pos, p2.pos, p3.pos, r.radius);
+		if (ballCenter && ballIsEmpty(ballCenter.value(), neighborhood, r.radius)) {
+		  r.state.markUsed(p1);
+		  r.state.markUsed(p2.id);
+		  r.state.markUsed(p3.id);
+		  r.context.seeds++;
+		  return SeedResult{ { p1, p2.id, p3.id }, ballCenter.value() };
 		}
 	  }
 	}
@@ -162,6 +602,19 @@ std::optional<SeedResult> findSeedTriangle(Grid& grid, float radius) {
   return {};
 }
 
+std::optional<SeedResult> findSeedTriangle(ReconstructionState& r) {
+  const auto& grid = r.grid;
+  std::vector<PointId> candidates;
+  for (std::size_t cell = 0; cell < grid.cellCount(); cell++) {
+	candidates.clear();
+	grid.forEachSlot(cell, [&](std::uint32_t slot) { candidates.push_back(grid.order[slot]); });
+	if (candidates.empty()) continue;
+	if (auto seed = findSeedTriangle(r, candidates, averageNormal(grid, cell)))
+	  return seed;
+  }
+  return {};
+}
+
 auto getActiveEdge(std::vector<MeshEdge*>& front) -> std::optional<MeshEdge*> {
   while (!front.empty()) {
 	auto* e = front.back();
@@ -173,78 +626,95 @@ auto getActiveEdge(std::vector<MeshEdge*>& front) -> std::optional<MeshEdge*> {
 }
 
 struct PivotResult {
-  MeshPoint* p;
+  PointId p;
   vec3 center;
 };
 
-std::optional<PivotResult> ballPivot(const MeshEdge* e, Grid& grid, float radius) {
-  const auto m = (e->a->pos + e->b->pos) / 2.0f;
+std::optional<PivotResult> ballPivot(ReconstructionState& r, const MeshEdge* e) {
+  const auto& grid = r.grid;
+  const auto radius = r.radius;
+  const auto a = grid.pos(e->a);
+  const auto b = grid.pos(e->b);
+  const auto m = (a + b) / 2.0f;
   const auto oldCenterVec = normalize(e->center - m);
-  auto neighborhood = grid.sphericalNeighborhood(m, { e->a->pos, e->b->pos, e->opposite->pos });
+  auto& neighborhood = r.context.scratch->neighborhood;
+  r.neighborhood(m, { a, b, grid.pos(e->opposite) }, neighborhood);
 
-  static auto counter = 0;
-  counter++;
+  const auto counter = ++r.context.pivots;
   if (debug) {
 	std::vector<vec3> points(neighborhood.size());
-	std::transform(begin(neighborhood), end(neighborhood), begin(points), [](const MeshPoint* p) { return p->pos; });
+	std::transform(begin(neighborhood), end(neighborhood), begin(points), [](const Neighbor& p) { return p.pos; });
   }
 
   auto smallestAngle = std::numeric_limits<float>::max();
-  MeshPoint* pointWithSmallestAngle = nullptr;
+  auto pointWithSmallestAngle = noSlot;
   vec3 centerOfSmallest{};
-  std::stringstream ss;
-  if (debug) ss << counter << ". pivoting edge a=" << e->a->pos << " b=" << e->b->pos << " op=" << e->opposite->pos << ". testing " << neighborhood.size() << " neighbors\n";
-  auto i = 0;
-  int smallestNumber = 0;
-  for (const auto& p : neighborhood) {
-	i++;
-	auto newFaceNormal = Triangle{ e->b->pos, e->a->pos, p->pos }.normal();
+  auto& ss = r.context.scratch->log;
+  if (debug) ss.str({});
+  if (debug) ss << counter << ". pivoting edge a=" << a << " b=" << b << " op=" << grid.pos(e->opposite) << ". testing " << neighborhood.size() << " neighbors\n";
+  // The ball center moves on a circle around m through the old center c0. A center touching p lies at distance radius
+  // from p, so it is at least |c0 - p| - radius away from c0, and a chord of length l on the circle is a turn with
+  // 1 - cos = l^2 / 2R^2. Candidates are visited by this bound and the loop stops once it exceeds the best angle found,
+  // which spares the ball center computation for most of a dense neighborhood.
+  const auto pivotRadius2 = length2(e->center - m);
+  auto& candidates = r.context.scratch->candidates;
+  candidates.clear();
+  for (std::uint32_t k = 0; k < neighborhood.size(); k++) {
+	const auto gap = std::max(0.0f, length(neighborhood[k].pos - e->center) - radius);
+	candidates.emplace_back(gap * gap / (2 * pivotRadius2), k);
+  }
+  std::sort(begin(candidates), end(candidates));
+
+  std::uint32_t smallestNumber = 0;
+  for (const auto& [bound, k] : candidates) {
+	// a little slack for rounding, the bound is tight for points right next to the old ball
+	if (bound - 1e-5f > smallestAngle)
+	  break;
+	const auto& p = neighborhood[k];
+	const auto i = k + 1;
+	auto newFaceNormal = faceNormal(b, a, p.pos);
 
 	// this check is not in the paper: all points' normals must point into the same half-space
-	if (dot(newFaceNormal, p->normal) < 0)
+	if (dot(newFaceNormal, p.normal) < 0)
 	  continue;
 
-	const auto c = computeBallCenter(MeshFace{ { e->b, e->a, p } }, radius);
+	const auto c = computeBallCenter(b, a, p.pos, radius);
 	if (!c) {
-	  if (debug) ss << i << ".    " << p->pos << " center computation failed\n";
+	  if (debug) ss << i << ".    " << p.pos << " center computation failed\n";
 	  continue;
 	}
 
-	if (debug) {
-	  static auto counter2 = 0;
-	  counter2++;
-	}
-
 	// this check is not in the paper: the ball center must always be above the triangle
 	const auto newCenterVec = normalize(c.value() - m);
 	const auto newCenterFaceDot = dot(newCenterVec, newFaceNormal);
 	if (newCenterFaceDot < 0) {
-	  if (debug) ss << i << ".    " << p->pos << " ball center " << c.value() << " underneath triangle\n";
+	  if (debug) ss << i << ".    " << p.pos << " ball center " << c.value() << " underneath triangle\n";
 	  continue;
 	}
 
 	// this check is not in the paper: points to which we already have an inner edge are not considered
-	for (const auto* ee : p->edges) {
-	  const auto* otherPoint = ee->a == p ? ee->b : ee->a;
-	  if (ee->status == EdgeStatus::inner && (otherPoint == e->a || otherPoint == e->b)) {
-		if (debug) ss << i << ".    " << p->pos << " inner edge exists\n";
-		goto nextneighbor;
-	  }
+	auto innerEdgeExists = false;
+	r.state.forEachEdge(p.id, [&](const MeshEdge* ee) {
+	  const auto otherPoint = ee->a == p.id ? ee->b : ee->a;
+	  if (ee->status == EdgeStatus::inner && (otherPoint == e->a || otherPoint == e->b))
+		innerEdgeExists = true;
+	});
+	if (innerEdgeExists) {
+	  if (debug) ss << i << ".    " << p.pos << " inner edge exists\n";
+	  continue;
 	}
 
-	{
-	  auto angle = std::acos(std::clamp(dot(oldCenterVec, newCenterVec), -1.0f, 1.0f));
-	  if (dot(cross(newCenterVec, oldCenterVec), e->a->pos - e->b->pos) < 0)
-		angle += std::numbers::pi_v<float>;
-	  if (angle < smallestAngle) {
-		smallestAngle = angle;
-		pointWithSmallestAngle = p;
-		centerOfSmallest = c.value();
-		smallestNumber = i;
-	  }
-	  if (debug) ss << i << ".    " << p->pos << " center " << c.value() << " angle " << angle << " newCenterFaceDot " << newCenterFaceDot << "\n";
+	// stands in for the angle, acos(cos) and acos(cos) + pi behind the edge, with the same order and no acos
+	const auto cosine = std::clamp(dot(oldCenterVec, newCenterVec), -1.0f, 1.0f);
+	const auto angle = dot(cross(newCenterVec, oldCenterVec), a - b) < 0 ? 3 - cosine : 1 - cosine;
+	// ties go to the earlier neighbor, as if the neighborhood was scanned in order
+	if (angle < smallestAngle || (angle == smallestAngle && i < smallestNumber)) {
+	  smallestAngle = angle;
+	  pointWithSmallestAngle = p.id;
+	  centerOfSmallest = c.value();
+	  smallestNumber = i;
 	}
-  nextneighbor:;
+	if (debug) ss << i << ".    " << p.pos << " center " << c.value() << " angle " << angle << " newCenterFaceDot " << newCenterFaceDot << "\n";
   }
 
   if (smallestAngle != std::numeric_limits<float>::max()) {
@@ -261,14 +731,16 @@ std::optional<PivotResult> ballPivot(const MeshEdge* e, Grid& grid, float radius
   return {};
 }
 
-bool notUsed(const MeshPoint* p) {
-  return !p->used;
+bool notUsed(const ReconstructionState& r, PointId p) {
+  return !r.state.used(p);
 }
 
-bool onFront(const MeshPoint* p) {
-  return std::any_of(begin(p->edges), end(p->edges), [&](const MeshEdge* e) {
-	return e->status == EdgeStatus::active;
+bool onFront(const ReconstructionState& r, PointId p) {
+  auto active = false;
+  r.state.forEachEdge(p, [&](const MeshEdge* e) {
+	active = active || e->status == EdgeStatus::active;
   });
+  return active;
 }
 
 void remove(MeshEdge* edge) {
@@ -276,41 +748,57 @@ void remove(MeshEdge* edge) {
   edge->status = EdgeStatus::inner;
 }
 
-void outputTriangle(MeshFace f, std::vector<Triangle>& triangles) {
-  triangles.push_back({ f[0]->pos, f[1]->pos, f[2]->pos });
+void reportProgress(ReconstructionState& r) {
+  const auto faces = std::span<const MeshFace>(r.faces).subspan(r.reported);
+  r.reported = r.faces.size();
+  if (!r.context.progress(faces))
+	r.cancelled = true;
 }
 
-std::tuple<MeshEdge*, MeshEdge*> join(MeshEdge* e_ij, MeshPoint* o_k, vec3 o_k_ballCenter, std::vector<MeshEdge*>& front, std::deque<MeshEdge>& edges) {
-  auto& e_ik = edges.emplace_back(MeshEdge{ e_ij->a, o_k, e_ij->b, o_k_ballCenter });
-  auto& e_kj = edges.emplace_back(MeshEdge{ o_k, e_ij->b, e_ij->a, o_k_ballCenter });
+void outputTriangle(ReconstructionState& r, MeshFace f) {
+  r.faces.push_back(f);
+  if (r.context.progress && r.faces.size() - r.reported >= r.context.progressInterval)
+	reportProgress(r);
+}
+
+// output triangles use the caller's positions, also when the reconstruction ran on quantized ones
+void appendTriangles(std::span<const Point> points, std::span<const MeshFace> faces, std::vector<Triangle>& triangles) {
+  triangles.reserve(triangles.size() + faces.size());
+  for (const auto& f : faces)
+	triangles.push_back({ points[f[0]].pos, points[f[1]].pos, points[f[2]].pos });
+}
+
+std::tuple<MeshEdge*, MeshEdge*> join(ReconstructionState& r, MeshEdge* e_ij, PointId o_k, vec3 o_k_ballCenter) {
+  auto& e_ik = r.edges.emplace_back(MeshEdge{ e_ij->a, o_k, e_ij->b, o_k_ballCenter });
+  auto& e_kj = r.edges.emplace_back(MeshEdge{ o_k, e_ij->b, e_ij->a, o_k_ballCenter });
 
   e_ik.next = &e_kj;
   e_ik.prev = e_ij->prev;
   e_ij->prev->next = &e_ik;
-  e_ij->a->edges.push_back(&e_ik);
+  r.state.addEdge(e_ij->a, &e_ik);
 
   e_kj.prev = &e_ik;
   e_kj.next = e_ij->next;
   e_ij->next->prev = &e_kj;
-  e_ij->b->edges.push_back(&e_kj);
+  r.state.addEdge(e_ij->b, &e_kj);
 
-  o_k->used = true;
-  o_k->edges.push_back(&e_ik);
-  o_k->edges.push_back(&e_kj);
+  r.state.markUsed(o_k);
+  r.state.addEdge(o_k, &e_ik);
+  r.state.addEdge(o_k, &e_kj);
 
-  front.push_back(&e_ik);
-  front.push_back(&e_kj);
+  r.front.push_back(&e_ik);
+  r.front.push_back(&e_kj);
   remove(e_ij);
 
   return { &e_ik, &e_kj };
 }
 
-void glue(MeshEdge* a, MeshEdge* b, std::vector<MeshEdge*>& front) {
+void glue(const Grid& grid, MeshEdge* a, MeshEdge* b, std::vector<MeshEdge*>& front) {
   if (debug) {
 	std::vector<Triangle> frontTriangles;
 	for (const auto* e : front)
 	  if (e->status == EdgeStatus::active)
-		frontTriangles.push_back(Triangle{ e->a->pos, e->a->pos, e->b->pos });
+		frontTriangles.push_back(Triangle{ grid.pos(e->a), grid.pos(e->a), grid.pos(e->b) });
   }
 
   // case 1
@@ -343,66 +831,357 @@ void glue(MeshEdge* a, MeshEdge* b, std::vector<MeshEdge*>& front) {
   remove(b);
 }
 
-MeshEdge* findReverseEdgeOnFront(MeshEdge* edge) {
-  for (auto& e : edge->a->edges)
+MeshEdge* findReverseEdgeOnFront(const ReconstructionState& r, MeshEdge* edge) {
+  // the edge lists run newest first, keep the last match to find the oldest reverse edge
+  MeshEdge* reverse = nullptr;
+  r.state.forEachEdge(edge->a, [&](MeshEdge* e) {
 	if (e->a == edge->b)
-	  return e;
-  return nullptr;
+	  reverse = e;
+  });
+  return reverse;
 }
 
-std::vector<Triangle> reconstruct(const std::vector<Point>& points, float radius) {
-  Grid grid(points, radius);
+void markBoundary(ReconstructionState& r, MeshEdge* e) {
+  e->status = EdgeStatus::boundary;
+  r.boundary[r.grid.linearIndex(r.grid.cellIndex((r.grid.pos(e->a) + r.grid.pos(e->b)) / 2.0f))].push_back(e);
+}
 
-  const auto seedResult = findSeedTriangle(grid, radius);
+void startFront(ReconstructionState& r, const SeedResult& seedResult) {
+  auto [seed, ballCenter] = seedResult;
+  outputTriangle(r, seed);
+  auto& e0 = r.edges.emplace_back(MeshEdge{ seed[0], seed[1], seed[2], ballCenter });
+  auto& e1 = r.edges.emplace_back(MeshEdge{ seed[1], seed[2], seed[0], ballCenter });
+  auto& e2 = r.edges.emplace_back(MeshEdge{ seed[2], seed[0], seed[1], ballCenter });
+  e0.prev = e1.next = &e2;
+  e0.next = e2.prev = &e1;
+  e1.prev = e2.next = &e0;
+  r.state.addEdge(seed[0], &e0);
+  r.state.addEdge(seed[0], &e2);
+  r.state.addEdge(seed[1], &e0);
+  r.state.addEdge(seed[1], &e1);
+  r.state.addEdge(seed[2], &e1);
+  r.state.addEdge(seed[2], &e2);
+  r.front.insert(end(r.front), { &e0, &e1, &e2 });
+}
+
+void expandFront(ReconstructionState& r) {
+  while (!r.cancelled) {
+	const auto e_ij = getActiveEdge(r.front);
+	if (!e_ij)
+	  break;
+	const auto o_k = ballPivot(r, e_ij.value());
+	if (o_k && (notUsed(r, o_k->p) || onFront(r, o_k->p))) {
+	  outputTriangle(r, { e_ij.value()->a, o_k->p, e_ij.value()->b });
+	  auto [e_ik, e_kj] = join(r, e_ij.value(), o_k->p, o_k->center);
+	  if (auto* e_ki = findReverseEdgeOnFront(r, e_ik)) glue(r.grid, e_ik, e_ki, r.front);
+	  if (auto* e_jk = findReverseEdgeOnFront(r, e_kj)) glue(r.grid, e_kj, e_jk, r.front);
+	} else {
+	  markBoundary(r, e_ij.value());
+	}
+  }
+}
+
+// Puts every boundary edge whose pivot neighborhood overlaps one of the given cells back onto the front.
+void reactivateBoundary(ReconstructionState& r, const std::vector<std::size_t>& touchedCells) {
+  auto& grid = r.grid;
+  for (const auto linear : touchedCells) {
+	const auto center = grid.cellIndex(linear);
+	for (auto xOff : { -1, 0, 1 }) {
+	  for (auto yOff : { -1, 0, 1 }) {
+		for (auto zOff : { -1, 0, 1 }) {
+		  const auto index = center + ivec3{ xOff, yOff, zOff };
+		  if (index.x < 0 || index.x >= grid.dims.x) continue;
+		  if (index.y < 0 || index.y >= grid.dims.y) continue;
+		  if (index.z < 0 || index.z >= grid.dims.z) continue;
+		  const auto it = r.boundary.find(grid.linearIndex(index));
+		  if (it == r.boundary.end()) continue;
+		  for (auto* e : it->second) {
+			// edges glued since they were marked are inner now
+			if (e->status != EdgeStatus::boundary) continue;
+			e->status = EdgeStatus::active;
+			r.front.push_back(e);
+		  }
+		  r.boundary.erase(it);
+		}
+	  }
+	}
+  }
+}
+
+// The boundary index is keyed by cell, so it has to be rebuilt whenever the grid changes its layout.
+void rekeyBoundary(ReconstructionState& r) {
+  std::vector<MeshEdge*> edges;
+  for (auto& [cell, cellEdges] : r.boundary)
+	for (auto* e : cellEdges)
+	  if (e->status == EdgeStatus::boundary)
+		edges.push_back(e);
+  r.boundary.clear();
+  for (auto* e : edges)
+	markBoundary(r, e);
+}
+
+std::vector<MeshFace> reconstructFaces(ReconstructionContext& context, std::span<const Point> points, float radius, const ReconstructionOptions& options) {
+  if (points.empty())
+	return {};
+  ReconstructionState r(context, points, radius, options);
+
+  const auto seedResult = findSeedTriangle(r);
   if (!seedResult) {
 	std::cerr << "No seed triangle found\n";
 	return {};
   }
 
-  std::vector<Triangle> triangles;
-  std::deque<MeshEdge> edges;
+  startFront(r, seedResult.value());
+  expandFront(r);
+  if (r.cancelled)
+	return std::move(r.faces);
 
-  auto [seed, ballCenter] = seedResult.value();
-  outputTriangle(seed, triangles);
-  auto& e0 = edges.emplace_back(MeshEdge{ seed[0], seed[1], seed[2], ballCenter });
-  auto& e1 = edges.emplace_back(MeshEdge{ seed[1], seed[2], seed[0], ballCenter });
-  auto& e2 = edges.emplace_back(MeshEdge{ seed[2], seed[0], seed[1], ballCenter });
-  e0.prev = e1.next = &e2;
-  e0.next = e2.prev = &e1;
-  e1.prev = e2.next = &e0;
-  seed[0]->edges = { &e0, &e2 };
-  seed[1]->edges = { &e0, &e1 };
-  seed[2]->edges = { &e1, &e2 };
-  std::vector<MeshEdge*> front{ &e0, &e1, &e2 };
-
-  while (auto e_ij = getActiveEdge(front)) {
-	const auto o_k = ballPivot(e_ij.value(), grid, radius);
-	if (o_k && (notUsed(o_k->p) || onFront(o_k->p))) {
-	  outputTriangle({ { e_ij.value()->a, o_k->p, e_ij.value()->b } }, triangles);
-	  auto [e_ik, e_kj] = join(e_ij.value(), o_k->p, o_k->center, front, edges);
-	  if (auto* e_ki = findReverseEdgeOnFront(e_ik)) glue(e_ik, e_ki, front);
-	  if (auto* e_jk = findReverseEdgeOnFront(e_kj)) glue(e_kj, e_jk, front);
-	} else {
-	  e_ij.value()->status = EdgeStatus::boundary;
-	}
+  if (options.maxHoleEdges > 0) {
+	HoleFillingStats stats;
+	const auto patches = fillHoles(points, r.faces, options.maxHoleEdges, &stats);
+	r.faces.insert(end(r.faces), begin(patches), end(patches));
+	if (debug) std::cerr << "filled " << stats.filled << " holes with " << patches.size() << " triangles, skipped " << stats.skipped << " loops\n";
   }
 
   if (debug) {
 	std::vector<Triangle> boundaryEdges;
-	for (const auto* e : front) {
-	  if (e->status == EdgeStatus::boundary)
-		boundaryEdges.push_back({ e->a->pos, e->a->pos, e->b->pos });
+	for (const auto& [cell, edges] : r.boundary) {
+	  for (const auto* e : edges)
+		boundaryEdges.push_back({ r.grid.pos(e->a), r.grid.pos(e->a), r.grid.pos(e->b) });
 	}
   }
 
+  if (context.progress && r.reported < r.faces.size())
+	reportProgress(r);
+
+  return std::move(r.faces);
+}
+
+std::vector<IndexedTriangle> reconstructIndexed(ReconstructionContext& context, std::span<const Point> points, float radius, const ReconstructionOptions& options) {
+  auto faces = reconstructFaces(context, points, radius, options);
+  if (options.deterministic)
+	canonicalize(faces);
+  return faces;
+}
+
+std::vector<IndexedTriangle> reconstructIndexed(std::span<const Point> points, float radius, const ReconstructionOptions& options) {
+  ReconstructionContext context;
+  return reconstructIndexed(context, points, radius, options);
+}
+
+std::vector<Triangle> reconstruct(ReconstructionContext& context, std::span<const Point> points, float radius, const ReconstructionOptions& options) {
+  const auto faces = reconstructFaces(context, points, radius, options);
+  std::vector<Triangle> triangles;
+  appendTriangles(points, faces, triangles);
+  if (options.deterministic)
+	canonicalize(triangles);
   return triangles;
 }
 
-std::vector<Triangle> measuredReconstruct(const std::vector<Point>& points, float radius) {
+std::vector<Triangle> reconstruct(std::span<const Point> points, float radius, const ReconstructionOptions& options) {
+  ReconstructionContext context;
+  return reconstruct(context, points, radius, options);
+}
+
+std::vector<Triangle> measuredReconstruct(std::span<const Point> points, float radius, const ReconstructionOptions& options) {
   const auto start = std::chrono::high_resolution_clock::now();
-  auto result = reconstruct(points, radius);
+  auto result = reconstruct(points, radius, options);
   const auto end = std::chrono::high_resolution_clock::now();
   const auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
   std::cerr << "[          ] Point: " << points.size() << " Triangles: " << result.size() << " T/s: " << result.size() / seconds << '\n';
   return result;
 }
+
+void benchmarkSpatialIndex(std::span<const Point> points, float radius, const ReconstructionOptions& options) {
+  for (const auto type : { SpatialIndexType::grid, SpatialIndexType::kdTree }) {
+	auto indexOptions = options;
+	indexOptions.index = type;
+	ReconstructionContext context;
+	const auto start = std::chrono::high_resolution_clock::now();
+	const auto faces = reconstructIndexed(context, points, radius, indexOptions);
+	const auto end = std::chrono::high_resolution_clock::now();
+	const auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+	std::cerr << "[  INDEX   ] " << (type == SpatialIndexType::grid ? "grid   " : "k-d tree") << " Point: " << points.size() << " Triangles: " << faces.size()
+			  << " Pivots: " << context.pivots << " Seconds: " << seconds << '\n';
+  }
+}
+
+std::vector<std::vector<Triangle>> reconstructAll(const std::vector<std::vector<Point>>& clouds, float radius, const ReconstructionOptions& options) {
+  std::vector<std::vector<Triangle>> meshes(clouds.size());
+  tbb::enumerable_thread_specific<ReconstructionContext> contexts;
+  parallelFor(clouds.size(), 1, options.deterministic, [&](std::size_t from, std::size_t to) {
+	auto& context = contexts.local();
+	for (auto i = from; i != to; i++)
+	  meshes[i] = reconstruct(context, clouds[i], radius, options);
+  });
+  return meshes;
+}
+
+std::vector<std::vector<Triangle>> measuredReconstructAll(const std::vector<std::vector<Point>>& clouds, float radius, const ReconstructionOptions& options) {
+  const auto start = std::chrono::high_resolution_clock::now();
+  auto result = reconstructAll(clouds, radius, options);
+  const auto end = std::chrono::high_resolution_clock::now();
+  const auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+  std::size_t points = 0;
+  std::size_t triangles = 0;
+  for (std::size_t i = 0; i < clouds.size(); i++) {
+	points += clouds[i].size();
+	triangles += result[i].size();
+  }
+  std::cerr << "[ " << clouds.size() << " SCANS ] Point: " << points << " Triangles: " << triangles << " T/s: " << triangles / seconds << '\n';
+  return result;
+}
+
+// Orders floats by their bit pattern mapped to a signed integer order, so -0 and 0 (or NaNs) can never tie and leave
+// the order of the sort up to the implementation.
+std::int32_t orderedBits(float f) {
+  const auto bits = std::bit_cast<std::int32_t>(f);
+  return bits < 0 ? bits ^ std::numeric_limits<std::int32_t>::max() : bits;
+}
+
+bool canonicalLess(const vec3& a, const vec3& b) {
+  for (auto i = 0; i < 3; i++)
+	if (orderedBits(a[i]) != orderedBits(b[i]))
+	  return orderedBits(a[i]) < orderedBits(b[i]);
+  return false;
+}
+
+void canonicalize(std::vector<Triangle>& triangles) {
+  parallelFor(triangles.size(), 4096, true, [&](std::size_t from, std::size_t to) {
+	for (auto i = from; i != to; i++) {
+	  auto& t = triangles[i];
+	  const auto first = canonicalLess(t[1], t[0]) ? (canonicalLess(t[2], t[1]) ? 2 : 1) : (canonicalLess(t[2], t[0]) ? 2 : 0);
+	  std::rotate(begin(t), begin(t) + first, end(t));
+	}
+  });
+  tbb::parallel_sort(begin(triangles), end(triangles), [](const Triangle& a, const Triangle& b) {
+	for (auto i = 0; i < 3; i++) {
+	  if (canonicalLess(a[i], b[i])) return true;
+	  if (canonicalLess(b[i], a[i])) return false;
+	}
+	return false;
+  });
+}
+
+void canonicalize(std::vector<IndexedTriangle>& triangles) {
+  for (auto& t : triangles)
+	std::rotate(begin(t), std::min_element(begin(t), end(t)), end(t));
+  tbb::parallel_sort(begin(triangles), end(triangles));
+}
+
+std::uint64_t meshDigest(const std::vector<Triangle>& triangles) {
+  return hashBytes(triangles.data(), triangles.size() * sizeof(Triangle));
+}
+
+bool checkDeterminism(const std::vector<Point>& points, float radius, const std::vector<int>& threadCounts) {
+  std::vector<std::uint64_t> digests;
+  for (const auto threads : threadCounts) {
+	tbb::task_arena arena(threads);
+	arena.execute([&] {
+	  digests.push_back(meshDigest(reconstruct(points, radius, { .deterministic = true })));
+	});
+  }
+
+  const auto agree = std::adjacent_find(begin(digests), end(digests), std::not_equal_to{}) == end(digests);
+  if (!agree) {
+	std::cerr << "Reconstruction is not deterministic:\n";
+	for (std::size_t i = 0; i < digests.size(); i++)
+	  std::cerr << "  " << threadCounts[i] << " threads: " << std::hex << digests[i] << std::dec << '\n';
+  }
+  return agree;
+}
+
+struct IncrementalReconstruction::State {
+  float radius;
+  ReconstructionOptions options;
+  ReconstructionContext context;
+  std::optional<ReconstructionState> reconstruction;
+  std::vector<Triangle> triangles;
+};
+
+IncrementalReconstruction::IncrementalReconstruction(float radius, const ReconstructionOptions& options)
+  : state{ std::make_unique<State>(State{ radius, options, {}, {}, {} }) } {}
+
+IncrementalReconstruction::~IncrementalReconstruction() = default;
+
+std::vector<Triangle> IncrementalReconstruction::insert(std::span<const Point> points) {
+  auto& reconstruction = state->reconstruction;
+  const auto firstNew = reconstruction ? reconstruction->grid.points.size() : 0;
+  if (points.size() <= firstNew)
+	return {};
+
+  std::vector<std::size_t> touched;
+  if (!reconstruction) {
+	reconstruction.emplace(state->context, points, state->radius, state->options);
+	touched.resize(reconstruction->grid.cellCount());
+	std::iota(begin(touched), end(touched), std::size_t{ 0 });
+  } else {
+	const auto lower = reconstruction->grid.lower;
+	const auto upper = reconstruction->grid.upper;
+	touched = reconstruction->grid.insert(points);
+	reconstruction->state.resize(points.size());
+	const auto relaid = reconstruction->grid.lower != lower || reconstruction->grid.upper != upper;
+	if (relaid)
+	  rekeyBoundary(*reconstruction);
+	if (reconstruction->useKdTree) {
+	  // quantized positions are relative to the cells, which moved with the bounds
+	  if (relaid && reconstruction->grid.quantized) {
+		reconstruction->tree = {};
+		reconstruction->extendIndex(0);
+	  } else
+		reconstruction->extendIndex(firstNew);
+	}
+  }
+
+  auto& r = *reconstruction;
+  const auto firstFace = r.faces.size();
+
+  reactivateBoundary(r, touched);
+  expandFront(r);
+
+  // new points that no reactivated edge reached start their own patch, older points already failed to seed one
+  std::vector<std::pair<std::size_t, PointId>> fresh;
+  for (auto i = firstNew; i < points.size(); i++)
+	fresh.emplace_back(r.grid.linearIndex(r.grid.cellIndex(points[i].pos)), static_cast<PointId>(i));
+  std::sort(begin(fresh), end(fresh));
+  std::vector<PointId> candidates;
+  for (std::size_t i = 0; i < fresh.size();) {
+	const auto cell = fresh[i].first;
+	candidates.clear();
+	for (; i < fresh.size() && fresh[i].first == cell; i++)
+	  candidates.push_back(fresh[i].second);
+	if (auto seed = findSeedTriangle(r, candidates, averageNormal(r.grid, cell))) {
+	  startFront(r, seed.value());
+	  expandFront(r);
+	}
+  }
+
+  std::vector<Triangle> added;
+  appendTriangles(points, std::span{ r.faces }.subspan(firstFace), added);
+  state->triangles.insert(end(state->triangles), begin(added), end(added));
+  return added;
+}
+
+const std::vector<Triangle>& IncrementalReconstruction::triangles() const {
+  return state->triangles;
+}
+
+std::vector<Triangle> measuredReconstructIncremental(std::span<const Point> points, float radius, std::size_t batchSize, const ReconstructionOptions& options) {
+  IncrementalReconstruction reconstruction(radius, options);
+  double firstSeconds = 0.0;
+  double lastSeconds = 0.0;
+  std::size_t inserts = 0;
+  for (std::size_t end = 0; end < points.size();) {
+	end = std::min(points.size(), end + std::max<std::size_t>(batchSize, 1));
+	const auto start = std::chrono::high_resolution_clock::now();
+	reconstruction.insert(points.first(end));
+	const auto stop = std::chrono::high_resolution_clock::now();
+	lastSeconds = std::chrono::duration_cast<std::chrono::duration<double>>(stop - start).count();
+	if (inserts++ == 0)
+	  firstSeconds = lastSeconds;
+  }
+  const auto& result = reconstruction.triangles();
+  std::cerr << "[INCREMENT ] Point: " << points.size() << " Triangles: " << result.size() << " Inserts: " << inserts
+			<< " First: " << firstSeconds << "s Last: " << lastSeconds << "s\n";
+  return result;
+}
@@ -1,6 +1,10 @@
 #pragma once
 
 #include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
 #include <vector>
 
 #include <glm/glm.hpp>
@@ -12,11 +16,107 @@ struct Triangle : std::array<glm::vec3, 3> {
   }
 };
 
+// a triangle as indices into the input points
+using IndexedTriangle = std::array<std::uint32_t, 3>;
+
 struct Point {
   Point(glm::vec3 p, glm::vec3 n) : pos{ p }, normal{ n } {}
   glm::vec3 pos;
   glm::vec3 normal;
 };
 
-std::vector<Triangle> reconstruct(const std::vector<Point>& points, float radius);
-std::vector<Triangle> measuredReconstruct(const std::vector<Point>& points, float radius);
+// Counters and scratch buffers of a reconstruction. Nothing in the reconstruction is shared between calls except
+// through the context, so reconstructions with separate contexts can run on different threads at the same time.
+class ReconstructionContext {
+ public:
+  ReconstructionContext();
+  ~ReconstructionContext();
+  ReconstructionContext(ReconstructionContext&&) noexcept;
+  ReconstructionContext& operator=(ReconstructionContext&&) noexcept;
+
+  // statistics accumulated over all reconstructions run with this context
+  std::size_t pivots = 0;
+  std::size_t seeds = 0;
+
+  // Called on the reconstructing thread with the faces found since the last call, as indices into the points, every
+  // progressInterval faces and once more at the end. Returning false cancels the reconstruction, which then returns the
+  // faces found so far without filling holes.
+  std::function<bool(std::span<const IndexedTriangle>)> progress;
+  std::size_t progressInterval = 4096;
+
+  struct Scratch;
+  std::unique_ptr<Scratch> scratch;
+};
+
+// Which structure answers the neighborhood queries of the pivot. The uniform grid is sized by the ball radius and
+// suits evenly sampled scans; the k-d tree adapts to the density, which pays off when a few regions are sampled far
+// more densely than the rest (scan station surroundings, overlapping scans).
+enum class SpatialIndexType {
+  grid,
+  kdTree
+};
+
+struct ReconstructionOptions {
+  // Bit-identical output for audit trails: parallel work uses a fixed decomposition and ordered reductions, and the
+  // triangles are returned in canonical order. Costs a sort of the output.
+  bool deterministic = false;
+  // Neighborhood scans read 16-bit fixed point positions relative to the grid cell and octahedral normals, 10 bytes
+  // per point instead of 24. Positions snap to 1/65535 of the cell size; the output keeps the original positions.
+  bool quantized = false;
+  // Lays the grid cells out along a Z-order curve, sorted with a parallel radix sort, and copies the points into that
+  // order (unless quantized, which stores its own copy anyway) so neighborhood scans stay in nearby memory.
+  bool mortonOrder = false;
+  SpatialIndexType index = SpatialIndexType::grid;
+  // Boundary loops of at most this many edges are closed afterwards (see fillHoles), 0 leaves all holes open. Not used
+  // by IncrementalReconstruction, where a hole may still be closed by later points.
+  std::uint32_t maxHoleEdges = 0;
+};
+
+// The points are used in place, through indices, and may be a mapped file (see PointFile). Per-point state is kept in
+// separate compact arrays.
+std::vector<Triangle> reconstruct(ReconstructionContext& context, std::span<const Point> points, float radius, const ReconstructionOptions& options = {});
+std::vector<Triangle> reconstruct(std::span<const Point> points, float radius, const ReconstructionOptions& options = {});
+std::vector<IndexedTriangle> reconstructIndexed(ReconstructionContext& context, std::span<const Point> points, float radius, const ReconstructionOptions& options = {});
+std::vector<IndexedTriangle> reconstructIndexed(std::span<const Point> points, float radius, const ReconstructionOptions& options = {});
+std::vector<Triangle> measuredReconstruct(std::span<const Point> points, float radius, const ReconstructionOptions& options = {});
+
+// Reconstructs the cloud once with each spatial index and reports the timings, to pick the index for a kind of scan.
+void benchmarkSpatialIndex(std::span<const Point> points, float radius, const ReconstructionOptions& options = {});
+
+// Reconstructs independent scans in parallel, one context per worker thread.
+std::vector<std::vector<Triangle>> reconstructAll(const std::vector<std::vector<Point>>& clouds, float radius, const ReconstructionOptions& options = {});
+std::vector<std::vector<Triangle>> measuredReconstructAll(const std::vector<std::vector<Point>>& clouds, float radius, const ReconstructionOptions& options = {});
+
+// Rotates each triangle to start at its smallest vertex, which keeps the winding, and sorts the triangles. Two meshes
+// with the same triangles are then equal byte for byte, whatever order they were generated in.
+void canonicalize(std::vector<Triangle>& triangles);
+void canonicalize(std::vector<IndexedTriangle>& triangles);
+// hash of the triangles as stored, canonicalize first to compare meshes from different runs
+std::uint64_t meshDigest(const std::vector<Triangle>& triangles);
+
+// Self-check of the deterministic mode: reconstructs the cloud once per thread count and compares the digests of the
+// results. Returns false and reports the digests if any run differs.
+bool checkDeterminism(const std::vector<Point>& points, float radius, const std::vector<int>& threadCounts = { 1, 2, 4 });
+
+// Ball pivoting that can be extended while a scan is still running. Each insert puts the boundary edges whose pivot
+// neighborhood gained points back onto the front and continues from there, so an update costs roughly in proportion
+// to the new points instead of the whole cloud. The points are used in place, like in reconstruct, the caller keeps
+// the growing cloud.
+class IncrementalReconstruction {
+ public:
+  explicit IncrementalReconstruction(float radius, const ReconstructionOptions& options = {});
+  ~IncrementalReconstruction();
+
+  // Takes the whole cloud so far, of which the points since the last call are new; the earlier ones must be unchanged
+  // but may have moved in memory. Returns the triangles added by this call.
+  std::vector<Triangle> insert(std::span<const Point> points);
+  const std::vector<Triangle>& triangles() const;
+
+ private:
+  struct State;
+  std::unique_ptr<State> state;
+};
+
+// Feeds the cloud to an IncrementalReconstruction in batches of batchSize points, as a scan arriving over time, and
+// reports the cost of the first and the last insert. Returns all triangles.
+std::vector<Triangle> measuredReconstructIncremental(std::span<const Point> points, float radius, std::size_t batchSize, const ReconstructionOptions& options = {});
@@ -0,0 +1,90 @@
+#include "cache_directory.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include <unistd.h>
+
+namespace fs = std::filesystem;
+
+// a temporary this old belongs to a writer that died, live writers finish an entry in far less
+constexpr auto staleTemporaryAge = std::chrono::hours{ 1 };
+
+bool writeCacheEntry(const fs::path& path, const std::function<void(std::ostream&)>& write) {
+  // process id and a counter, so neither other processes nor other threads write the same temporary
+  static std::atomic<std::uint64_t> writes{ 0 };
+  auto tmpPath = path;
+  tmpPath += "." + std::to_string(::getpid()) + "-" + std::to_string(writes++) + ".tmp";
+
+  {
+	std::ofstream out{ tmpPath, std::ios::binary | std::ios::trunc };
+	write(out);
+	if (!out) {
+	  std::cerr << "Could not write cache entry " << tmpPath << '\n';
+	  out.close();
+	  std::error_code ec;
+	  fs::remove(tmpPath, ec);
+	  return false;
+	}
+  }
+
+  // rename is atomic, so concurrent readers only ever see complete entries
+  std::error_code ec;
+  fs::rename(tmpPath, path, ec);
+  if (ec) {
+	std::cerr << "Could not store cache entry " << path << ": " << ec.message() << '\n';
+	fs::remove(tmpPath, ec);
+	return false;
+  }
+  return true;
+}
+
+void evictCacheEntries(const fs::path& directory, std::string_view extension, std::uintmax_t budgetBytes) {
+  struct Entry {
+	fs::path path;
+	std::uintmax_t size;
+	fs::file_time_type lastUse;
+  };
+
+  const auto now = fs::file_time_type::clock::now();
+  std::error_code ec;
+  std::vector<Entry> entries;
+  std::uintmax_t total = 0;
+  for (const auto& file : fs::directory_iterator(directory, ec)) {
+	if (!file.is_regular_file(ec))
+	  continue;
+	const auto fileExtension = file.path().extension();
+	if (fileExtension != ".tmp" && fileExtension != extension)
+	  continue;
+	// entries removed or unreadable meanwhile report a size of -1, which would evict everything else
+	std::error_code sizeError;
+	std::error_code timeError;
+	const auto size = file.file_size(sizeError);
+	const auto lastUse = file.last_write_time(timeError);
+	if (sizeError || timeError)
+	  continue;
+	if (fileExtension == ".tmp") {
+	  if (now - lastUse > staleTemporaryAge)
+		fs::remove(file.path(), ec);
+	  continue;
+	}
+	entries.push_back({ file.path(), size, lastUse });
+	total += size;
+  }
+
+  std::sort(begin(entries), end(entries), [](const Entry& a, const Entry& b) {
+	return a.lastUse < b.lastUse;
+  });
+
+  // always keep the most recent entry, even if it alone exceeds the budget
+  for (std::size_t i = 0; total > budgetBytes && i + 1 < entries.size(); i++) {
+	if (fs::remove(entries[i].path, ec))
+	  total -= entries[i].size;
+  }
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <ostream>
+#include <string_view>
+
+// Helpers shared by the on-disk caches, which keep one file per entry in a directory of their own and use the
+// modification time of an entry as its last use.
+
+// Writes an entry through a temporary file unique to this writer, then renames it into place. The rename is atomic, so
+// readers only ever see complete entries, and writers of the same entry at the same time never share a temporary.
+// Returns false, after reporting why, if the entry could not be written.
+bool writeCacheEntry(const std::filesystem::path& path, const std::function<void(std::ostream&)>& write);
+
+// Removes the least recently used entries with the given extension until the directory fits the budget, but always
+// keeps the most recent one. Temporaries that were left behind by a crashed writer are removed as well.
+void evictCacheEntries(const std::filesystem::path& directory, std::string_view extension, std::uintmax_t budgetBytes);
@@ -94,6 +94,14 @@ class Camera {
 		updateCameraVectors();
 	}
 
+	// moves the camera to a pose given directly, as scripted camera paths do
+	void Place(glm::vec3 position, float yaw, float pitch) {
+		Position = position;
+		Yaw = yaw;
+		Pitch = pitch;
+		updateCameraVectors();
+	}
+
 	// processes input received from a mouse scroll-wheel event. Only requires input on the vertical wheel-axis
 	void ProcessMouseScroll(float yoffset) {
 		Zoom -= (float)yoffset;
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "camera.h"
+
+struct CameraKey {
+  glm::vec3 position;
+  float yaw;
+  float pitch;
+};
+
+// Scripted camera for benchmarks, linear between evenly spaced keys so every run renders the same frames.
+class CameraPath {
+ public:
+  explicit CameraPath(std::vector<CameraKey> k) : keys{ std::move(k) } {}
+
+  // t from 0 at the first key to 1 at the last
+  void apply(Camera& camera, float t) const {
+	if (keys.empty())
+	  return;
+	const auto segments = keys.size() - 1;
+	const auto position = std::clamp(t, 0.0f, 1.0f) * static_cast<float>(segments);
+	const auto i = std::min(static_cast<std::size_t>(position), segments > 0 ? segments - 1 : 0);
+	const auto& a = keys[i];
+	const auto& b = keys[std::min(i + 1, segments)];
+	const auto f = position - static_cast<float>(i);
+	camera.Place(glm::mix(a.position, b.position, f), glm::mix(a.yaw, b.yaw, f), glm::mix(a.pitch, b.pitch, f));
+  }
+
+ private:
+  std::vector<CameraKey> keys;
+};
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "aabb.h"
+#include "bpa.h"
+#include "frustum.h"
+
+inline AABB itemBounds(const Point& point) {
+  return { point.pos, point.pos };
+}
+
+inline AABB itemBounds(const Triangle& triangle) {
+  return { glm::max(glm::max(triangle[0], triangle[1]), triangle[2]), glm::min(glm::min(triangle[0], triangle[1]), triangle[2]) };
+}
+
+// Points or triangles sorted into the cubes of a uniform grid, with the bounds of every non-empty cube, so the renderer
+// can upload them once and draw only the ranges of the chunks in view. Items are bucketed by the center of their bounds
+// and a chunk's bounds grow to cover the items sticking out of its cube.
+template <typename T>
+class Chunked {
+ public:
+  Chunked(const std::vector<T>& items, float chunkSize) : m_id(++nextId()) {
+	if (items.empty())
+	  return;
+	auto lower = itemBounds(items.front()).center();
+	for (const auto& item : items)
+	  lower = glm::min(lower, itemBounds(item).center());
+
+	// sorted by cube, only the non-empty cubes become chunks
+	std::vector<std::uint64_t> keys(items.size());
+	for (std::size_t i = 0; i < items.size(); i++) {
+	  const auto cube = glm::uvec3{ (itemBounds(items[i]).center() - lower) / chunkSize };
+	  keys[i] = static_cast<std::uint64_t>(cube.z) << 42 | static_cast<std::uint64_t>(cube.y) << 21 | cube.x;
+	}
+	std::vector<std::uint32_t> order(items.size());
+	for (std::uint32_t i = 0; i < order.size(); i++)
+	  order[i] = i;
+	std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) { return keys[a] < keys[b]; });
+
+	m_items.reserve(items.size());
+	auto chunk = itemBounds(items[order.front()]);
+	for (std::size_t slot = 0; slot < order.size(); slot++) {
+	  const auto& item = items[order[slot]];
+	  if (slot == 0 || keys[order[slot]] != keys[order[slot - 1]]) {
+		if (slot > 0)
+		  m_bounds.push_back(chunk);
+		m_chunkBegin.push_back(static_cast<std::uint32_t>(slot));
+		chunk = itemBounds(item);
+	  } else
+		chunk.extend(itemBounds(item));
+	  m_items.push_back(item);
+	}
+	m_bounds.push_back(chunk);
+	m_chunkBegin.push_back(static_cast<std::uint32_t>(m_items.size()));
+  }
+
+  const std::vector<T>& items() const { return m_items; }
+  std::size_t chunkCount() const { return m_bounds.size(); }
+  // identifies the contents for GPU buffers, unique for every Chunked ever built
+  std::uint64_t id() const { return m_id; }
+
+  // First item and item count of the chunks in the frustum, chunks next to each other in items() merged into one range.
+  // Ready for glMultiDrawArrays once multiplied by the vertices per item.
+  void visibleRanges(const Frustum& frustum, std::vector<std::int32_t>& first, std::vector<std::int32_t>& count) const {
+	first.clear();
+	count.clear();
+	m_bounds.cull(frustum.planes, m_visible);
+	for (const auto chunk : m_visible) {
+	  const auto begin = static_cast<std::int32_t>(m_chunkBegin[chunk]);
+	  const auto size = static_cast<std::int32_t>(m_chunkBegin[chunk + 1] - m_chunkBegin[chunk]);
+	  if (!first.empty() && first.back() + count.back() == begin)
+		count.back() += size;
+	  else {
+		first.push_back(begin);
+		count.push_back(size);
+	  }
+	}
+  }
+
+ private:
+  static std::atomic<std::uint64_t>& nextId() {
+	static std::atomic<std::uint64_t> id{ 0 };
+	return id;
+  }
+
+  std::uint64_t m_id;
+  std::vector<T> m_items;
+  std::vector<std::uint32_t> m_chunkBegin;
+  AABBBatch m_bounds;
+  mutable std::vector<std::uint32_t> m_visible;
+};
@@ -0,0 +1,408 @@
+#include "decimate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iostream>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <unordered_map>
+
+#include "hash.h"
+#include "parallel.h"
+
+using namespace glm;
+
+namespace {
+constexpr auto noVertex = std::numeric_limits<std::uint32_t>::max();
+
+auto edgeKey(std::uint32_t a, std::uint32_t b) -> std::uint64_t {
+  return static_cast<std::uint64_t>(std::min(a, b)) << 32 | std::max(a, b);
+}
+
+// symmetric 4x4 matrix of the plane equations, the upper triangle row by row
+struct Quadric {
+  std::array<double, 10> q{};
+
+  static Quadric plane(dvec3 n, double d, double weight) {
+	return { { n.x * n.x * weight, n.x * n.y * weight, n.x * n.z * weight, n.x * d * weight, n.y * n.y * weight, n.y * n.z * weight, n.y * d * weight, n.z * n.z * weight, n.z * d * weight, d * d * weight } };
+  }
+
+  Quadric& operator+=(const Quadric& o) {
+	for (std::size_t i = 0; i < q.size(); i++)
+	  q[i] += o.q[i];
+	return *this;
+  }
+
+  Quadric operator+(const Quadric& o) const {
+	auto result = *this;
+	return result += o;
+  }
+
+  double error(dvec3 p) const {
+	return q[0] * p.x * p.x + 2 * q[1] * p.x * p.y + 2 * q[2] * p.x * p.z + 2 * q[3] * p.x
+		   + q[4] * p.y * p.y + 2 * q[5] * p.y * p.z + 2 * q[6] * p.y
+		   + q[7] * p.z * p.z + 2 * q[8] * p.z + q[9];
+  }
+
+  // the point of smallest error, none if the planes do not pin it down
+  std::optional<dvec3> minimum() const {
+	const auto a = q[0], b = q[1], c = q[2], d = q[4], e = q[5], f = q[7];
+	// cofactors of the symmetric 3x3 block
+	const auto c00 = d * f - e * e;
+	const auto c01 = c * e - b * f;
+	const auto c02 = b * e - c * d;
+	const auto c11 = a * f - c * c;
+	const auto c12 = b * c - a * e;
+	const auto c22 = a * d - b * b;
+	const auto det = a * c00 + b * c01 + c * c02;
+	const auto trace = a + d + f;
+	if (std::abs(det) <= 1e-9 * trace * trace * trace)
+	  return {};
+	const auto r = -dvec3{ q[3], q[6], q[8] };
+	return dvec3{ c00 * r.x + c01 * r.y + c02 * r.z, c01 * r.x + c11 * r.y + c12 * r.z, c02 * r.x + c12 * r.y + c22 * r.z } / det;
+  }
+};
+
+struct Candidate {
+  double cost;
+  std::uint32_t u;
+  std::uint32_t v;
+  std::uint32_t uVersion;
+  std::uint32_t vVersion;
+  dvec3 target;
+
+  bool operator>(const Candidate& o) const {
+	return cost > o.cost;
+  }
+};
+
+struct Decimator {
+  // per chunk, so chunks can be decimated in parallel
+  struct Scratch {
+	std::vector<Candidate> heap;
+	std::vector<std::uint32_t> uRing;
+	std::vector<std::uint32_t> vRing;
+  };
+
+  explicit Decimator(const IndexedMesh& mesh)
+	: positions(begin(mesh.positions), end(mesh.positions)), faces(mesh.triangles), faceRemoved(faces.size()), quadrics(positions.size()),
+	  vertexFaces(positions.size()), locked(positions.size()), version(positions.size()) {
+	std::unordered_map<std::uint64_t, std::uint32_t> edgeUses;
+	edgeUses.reserve(faces.size() * 2);
+	for (std::uint32_t f = 0; f < faces.size(); f++) {
+	  const auto& t = faces[f];
+	  const auto normal = cross(positions[t[1]] - positions[t[0]], positions[t[2]] - positions[t[0]]);
+	  const auto area2 = length(normal);
+	  // area weighted, so slivers do not pin their vertices
+	  if (area2 > 0) {
+		const auto n = normal / area2;
+		const auto plane = Quadric::plane(n, -dot(n, positions[t[0]]), area2 / 2);
+		for (const auto v : t)
+		  quadrics[v] += plane;
+	  }
+	  for (auto i = 0; i < 3; i++) {
+		vertexFaces[t[i]].push_back(f);
+		edgeUses[edgeKey(t[i], t[(i + 1) % 3])]++;
+	  }
+	}
+	for (const auto& t : faces) {
+	  for (auto i = 0; i < 3; i++) {
+		if (edgeUses[edgeKey(t[i], t[(i + 1) % 3])] != 2)
+		  locked[t[i]] = locked[t[(i + 1) % 3]] = 1;
+	  }
+	}
+	liveFaces = faces.size();
+  }
+
+  auto faceNormal(const IndexedTriangle& t) const -> dvec3 {
+	return cross(positions[t[1]] - positions[t[0]], positions[t[2]] - positions[t[0]]);
+  }
+
+  Candidate candidate(std::uint32_t u, std::uint32_t v) const {
+	const auto q = quadrics[u] + quadrics[v];
+	auto target = q.minimum();
+	// nearly flat surroundings leave the minimum poorly conditioned, it must stay close to the edge
+	const auto mid = (positions[u] + positions[v]) / 2.0;
+	if (target && length(*target - mid) > 2 * length(positions[u] - positions[v]))
+	  target.reset();
+	if (!target) {
+	  target = std::min({ positions[u], positions[v], mid }, [&](dvec3 a, dvec3 b) { return q.error(a) < q.error(b); });
+	}
+	return { std::max(0.0, q.error(*target)), u, v, version[u], version[v], *target };
+  }
+
+  // No triangle around the edge may flip or degenerate, and u and v may share no neighbors besides the opposite
+  // corners of their two common triangles (the link condition), otherwise the mesh pinches into a non-manifold fan.
+  bool collapsible(std::uint32_t u, std::uint32_t v, dvec3 target, Scratch& scratch) const {
+	auto shared = 0;
+	for (const auto x : { u, v }) {
+	  auto& ring = x == u ? scratch.uRing : scratch.vRing;
+	  ring.clear();
+	  const auto other = x == u ? v : u;
+	  for (const auto f : vertexFaces[x]) {
+		if (faceRemoved[f]) continue;
+		const auto& t = faces[f];
+		for (const auto w : t)
+		  if (w != x && w != other) ring.push_back(w);
+		if (t[0] == other || t[1] == other || t[2] == other) {
+		  shared += x == u;
+		  continue;
+		}
+
+		const auto corner = [&](std::uint32_t w) { return w == x ? target : positions[w]; };
+		const auto before = faceNormal(t);
+		const auto after = cross(corner(t[1]) - corner(t[0]), corner(t[2]) - corner(t[0]));
+		if (dot(after, after) <= 1e-12 * dot(before, before) || dot(normalize(after), normalize(before)) < 0.2)
+		  return false;
+	  }
+	  std::sort(begin(ring), end(ring));
+	  ring.erase(std::unique(begin(ring), end(ring)), end(ring));
+	}
+	if (shared != 2)
+	  return false;
+	std::size_t common = 0;
+	for (auto i = begin(scratch.uRing), j = begin(scratch.vRing); i != end(scratch.uRing) && j != end(scratch.vRing);) {
+	  if (*i < *j)
+		i++;
+	  else if (*j < *i)
+		j++;
+	  else {
+		common++;
+		i++;
+		j++;
+	  }
+	}
+	return common == 2;
+  }
+
+  // returns the number of removed triangles
+  std::size_t collapse(const Candidate& c, Scratch& scratch) {
+	const auto u = c.u;
+	const auto v = c.v;
+	positions[u] = c.target;
+	quadrics[u] += quadrics[v];
+	version[u]++;
+	version[v]++;
+
+	std::size_t removed = 0;
+	for (const auto f : vertexFaces[v]) {
+	  if (faceRemoved[f]) continue;
+	  auto& t = faces[f];
+	  if (t[0] == u || t[1] == u || t[2] == u) {
+		faceRemoved[f] = 1;
+		removed++;
+		continue;
+	  }
+	  for (auto& w : t)
+		if (w == v) w = u;
+	  vertexFaces[u].push_back(f);
+	}
+	vertexFaces[v].clear();
+	std::erase_if(vertexFaces[u], [&](std::uint32_t f) { return faceRemoved[f] != 0; });
+
+	for (const auto f : vertexFaces[u]) {
+	  for (const auto w : faces[f]) {
+		if (w == u || !free[w]) continue;
+		scratch.heap.push_back(candidate(u, w));
+		std::push_heap(begin(scratch.heap), end(scratch.heap), std::greater<>{});
+	  }
+	}
+	return removed;
+  }
+
+  // collapses the cheapest edges between free vertices of the chunk, returns the number of removed triangles
+  std::size_t decimateChunk(std::span<const std::uint32_t> chunkFaces, std::size_t budget, float maxError) {
+	Scratch scratch;
+	auto& heap = scratch.heap;
+	for (const auto f : chunkFaces) {
+	  const auto& t = faces[f];
+	  for (auto i = 0; i < 3; i++) {
+		const auto a = t[i];
+		const auto b = t[(i + 1) % 3];
+		if (a < b && free[a] && free[b])
+		  heap.push_back(candidate(a, b));
+	  }
+	}
+	std::make_heap(begin(heap), end(heap), std::greater<>{});
+
+	std::size_t removed = 0;
+	while (!heap.empty() && removed < budget) {
+	  std::pop_heap(begin(heap), end(heap), std::greater<>{});
+	  const auto c = heap.back();
+	  heap.pop_back();
+	  if (c.uVersion != version[c.u] || c.vVersion != version[c.v]) continue;
+	  if (maxError > 0 && c.cost > maxError) break;
+	  if (!collapsible(c.u, c.v, c.target, scratch)) continue;
+	  removed += collapse(c, scratch);
+	}
+	return removed;
+  }
+
+  // One parallel pass over chunks shifted by offset (in chunk sizes). Returns the number of removed triangles.
+  std::size_t pass(float chunkSize, float offset, std::size_t budget, float maxError) {
+	auto lower = dvec3{ std::numeric_limits<double>::max() };
+	auto upper = dvec3{ std::numeric_limits<double>::lowest() };
+	for (std::uint32_t v = 0; v < positions.size(); v++) {
+	  if (vertexFaces[v].empty()) continue;
+	  lower = min(lower, positions[v]);
+	  upper = max(upper, positions[v]);
+	}
+	const auto dims = ivec3{ (upper - lower) / static_cast<double>(chunkSize) + 2.0 };
+	const auto chunkOf = [&](std::uint32_t v) {
+	  const auto index = ivec3{ (positions[v] - lower) / static_cast<double>(chunkSize) + static_cast<double>(offset) };
+	  return static_cast<std::uint32_t>((index.z * dims.y + index.y) * dims.x + index.x);
+	};
+
+	// faces by chunk, those crossing a border in none, and their vertices pinned for this pass
+	free.assign(positions.size(), 0);
+	for (std::uint32_t v = 0; v < positions.size(); v++)
+	  free[v] = !locked[v] && !vertexFaces[v].empty();
+	std::vector<std::uint32_t> faceChunk(faces.size(), noVertex);
+	std::vector<std::uint32_t> chunkStart(static_cast<std::size_t>(dims.x * dims.y * dims.z) + 1);
+	for (std::uint32_t f = 0; f < faces.size(); f++) {
+	  if (faceRemoved[f]) continue;
+	  const auto& t = faces[f];
+	  const auto chunk = chunkOf(t[0]);
+	  if (chunkOf(t[1]) == chunk && chunkOf(t[2]) == chunk) {
+		faceChunk[f] = chunk;
+		chunkStart[chunk + 1]++;
+	  } else
+		free[t[0]] = free[t[1]] = free[t[2]] = 0;
+	}
+	for (std::size_t c = 1; c < chunkStart.size(); c++)
+	  chunkStart[c] += chunkStart[c - 1];
+	std::vector<std::uint32_t> chunkFaces(chunkStart.back());
+	{
+	  auto fill = chunkStart;
+	  for (std::uint32_t f = 0; f < faces.size(); f++)
+		if (faceChunk[f] != noVertex)
+		  chunkFaces[fill[faceChunk[f]]++] = f;
+	}
+
+	// every chunk removes its share of the budget, in proportion to its triangles
+	const auto share = static_cast<double>(budget) / static_cast<double>(liveFaces);
+	std::vector<std::size_t> removed(chunkStart.size() - 1);
+	parallelFor(removed.size(), 1, false, [&](std::size_t from, std::size_t to) {
+	  for (auto c = from; c < to; c++) {
+		const auto count = chunkStart[c + 1] - chunkStart[c];
+		if (count == 0) continue;
+		const auto chunkBudget = budget == std::numeric_limits<std::size_t>::max() ? budget : static_cast<std::size_t>(std::ceil(count * share));
+		removed[c] = decimateChunk({ chunkFaces.data() + chunkStart[c], count }, chunkBudget, maxError);
+	  }
+	});
+	const auto total = std::accumulate(begin(removed), end(removed), std::size_t{ 0 });
+	liveFaces -= total;
+	return total;
+  }
+
+  IndexedMesh result() const {
+	IndexedMesh mesh;
+	std::vector<std::uint32_t> remap(positions.size(), noVertex);
+	for (std::uint32_t f = 0; f < faces.size(); f++) {
+	  if (faceRemoved[f]) continue;
+	  auto t = faces[f];
+	  for (auto& v : t) {
+		if (remap[v] == noVertex) {
+		  remap[v] = static_cast<std::uint32_t>(mesh.positions.size());
+		  mesh.positions.push_back(vec3{ positions[v] });
+		}
+		v = remap[v];
+	  }
+	  mesh.triangles.push_back(t);
+	}
+	return mesh;
+  }
+
+  std::vector<dvec3> positions;
+  std::vector<IndexedTriangle> faces;
+  std::vector<std::uint8_t> faceRemoved;
+  std::vector<Quadric> quadrics;
+  std::vector<std::vector<std::uint32_t>> vertexFaces;
+  // on the boundary or on a non-manifold edge
+  std::vector<std::uint8_t> locked;
+  // bumped by every collapse touching the vertex, outdated candidates are skipped
+  std::vector<std::uint32_t> version;
+  // unlocked and only in triangles inside its chunk, recomputed every pass
+  std::vector<std::uint8_t> free;
+  std::size_t liveFaces = 0;
+};
+}
+
+IndexedMesh indexMesh(const std::vector<Triangle>& triangles) {
+  struct PositionHash {
+	std::size_t operator()(const vec3& p) const {
+	  return hashBytes(&p, sizeof(p));
+	}
+  };
+  std::unordered_map<vec3, std::uint32_t, PositionHash> ids;
+  ids.reserve(triangles.size());
+  IndexedMesh mesh;
+  mesh.triangles.reserve(triangles.size());
+  for (const auto& t : triangles) {
+	IndexedTriangle indexed;
+	for (auto i = 0; i < 3; i++) {
+	  const auto [it, inserted] = ids.try_emplace(t[i], static_cast<std::uint32_t>(mesh.positions.size()));
+	  if (inserted)
+		mesh.positions.push_back(t[i]);
+	  indexed[i] = it->second;
+	}
+	mesh.triangles.push_back(indexed);
+  }
+  return mesh;
+}
+
+IndexedMesh indexMesh(std::span<const Point> points, const std::vector<IndexedTriangle>& triangles) {
+  IndexedMesh mesh;
+  mesh.positions.reserve(points.size());
+  for (const auto& p : points)
+	mesh.positions.push_back(p.pos);
+  mesh.triangles = triangles;
+  return mesh;
+}
+
+std::vector<Triangle> toTriangles(const IndexedMesh& mesh) {
+  std::vector<Triangle> triangles;
+  triangles.reserve(mesh.triangles.size());
+  for (const auto& t : mesh.triangles)
+	triangles.push_back({ mesh.positions[t[0]], mesh.positions[t[1]], mesh.positions[t[2]] });
+  return triangles;
+}
+
+IndexedMesh decimate(const IndexedMesh& mesh, const DecimationOptions& options) {
+  if (mesh.triangles.empty() || (options.targetTriangles == 0 && options.maxError <= 0))
+	return mesh;
+
+  Decimator decimator(mesh);
+  auto lower = mesh.positions.front();
+  auto upper = lower;
+  for (const auto& p : mesh.positions) {
+	lower = min(lower, p);
+	upper = max(upper, p);
+  }
+  const auto extent = std::max({ upper.x - lower.x, upper.y - lower.y, upper.z - lower.z, std::numeric_limits<float>::min() });
+  const auto chunkSize = options.chunkSize > 0 ? options.chunkSize : extent / 32;
+
+  // Alternates between the two chunk grids and doubles the chunks every other pass, since the triangles grow and more of
+  // them cross the borders. Once a chunk holds the whole mesh the pass is serial and catches whatever is left.
+  for (auto round = 0;; round++) {
+	const auto budget = options.targetTriangles == 0 ? std::numeric_limits<std::size_t>::max() : decimator.liveFaces - std::min(decimator.liveFaces, options.targetTriangles);
+	if (budget == 0)
+	  break;
+	const auto size = chunkSize * static_cast<float>(1 << std::min(round / 2, 30));
+	if (decimator.pass(size, round % 2 ? 0.5f : 0.0f, budget, options.maxError) == 0 && size > extent)
+	  break;
+  }
+  return decimator.result();
+}
+
+IndexedMesh measuredDecimate(const IndexedMesh& mesh, const DecimationOptions& options) {
+  const auto start = std::chrono::high_resolution_clock::now();
+  auto result = decimate(mesh, options);
+  const auto end = std::chrono::high_resolution_clock::now();
+  const auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+  std::cerr << "[ DECIMATE ] Triangles: " << mesh.triangles.size() << " -> " << result.triangles.size() << " Seconds: " << seconds << '\n';
+  return result;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bpa.h"
+
+// Triangles sharing their vertices, the form the decimator works on.
+struct IndexedMesh {
+  std::vector<glm::vec3> positions;
+  std::vector<IndexedTriangle> triangles;
+};
+
+// Welds the corners with bit-identical positions, which turns the triangles of reconstruct back into a shared mesh.
+IndexedMesh indexMesh(const std::vector<Triangle>& triangles);
+IndexedMesh indexMesh(std::span<const Point> points, const std::vector<IndexedTriangle>& triangles);
+std::vector<Triangle> toTriangles(const IndexedMesh& mesh);
+
+struct DecimationOptions {
+  // collapse until the mesh has at most this many triangles, 0 for no limit
+  std::size_t targetTriangles = 0;
+  // largest error of a collapse, a squared distance to the planes of the original triangles, 0 for no limit
+  float maxError = 0.0f;
+  // side of the cubes the mesh is cut into for the first parallel passes, 0 uses 1/32 of the largest extent
+  float chunkSize = 0.0f;
+};
+
+// Quadric error metric edge collapse (Garland and Heckbert 1997) down to a triangle count or an error budget, whichever
+// is reached first. The mesh is cut into spatial chunks which are decimated in parallel. Vertices of triangles that
+// cross a chunk border stay fixed during a pass, the next pass shifts the chunks by half their size so the borders get
+// their turn, and the chunks grow along with the triangles. Boundary vertices never move, holes and the border of a scan keep their shape.
+IndexedMesh decimate(const IndexedMesh& mesh, const DecimationOptions& options);
+IndexedMesh measuredDecimate(const IndexedMesh& mesh, const DecimationOptions& options);
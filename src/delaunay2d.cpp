@@ -0,0 +1,231 @@
+#include "delaunay2d.h"
+
+#include <algorithm>
+#include <limits>
+#include <numeric>
+
+using namespace glm;
+
+namespace {
+
+constexpr auto none = std::numeric_limits<std::uint32_t>::max();
+
+// n[i] is the triangle across the edge opposite of v[i]
+struct Tri {
+  std::array<std::uint32_t, 3> v;
+  std::array<std::uint32_t, 3> n;
+};
+
+double orient(dvec2 a, dvec2 b, dvec2 c) {
+  return (b.x - a.x) * (c.y - a.y) - (b.y - a.y) * (c.x - a.x);
+}
+
+// positive if d lies inside the circumcircle of the counter-clockwise triangle abc
+double inCircle(dvec2 a, dvec2 b, dvec2 c, dvec2 d) {
+  const auto ad = a - d;
+  const auto bd = b - d;
+  const auto cd = c - d;
+  const auto a2 = dot(ad, ad);
+  const auto b2 = dot(bd, bd);
+  const auto c2 = dot(cd, cd);
+  return ad.x * (bd.y * c2 - b2 * cd.y) - ad.y * (bd.x * c2 - b2 * cd.x) + a2 * (bd.x * cd.y - bd.y * cd.x);
+}
+
+// position along a 16 bit hilbert curve, used to insert points in a spatially coherent order
+std::uint32_t hilbertIndex(std::uint32_t x, std::uint32_t y) {
+  std::uint32_t d = 0;
+  for (std::uint32_t s = 1u << 15; s > 0; s /= 2) {
+	const auto rx = (x & s) > 0 ? 1u : 0u;
+	const auto ry = (y & s) > 0 ? 1u : 0u;
+	d += s * s * ((3 * rx) ^ ry);
+	if (ry == 0) {
+	  if (rx == 1) {
+		x = s - 1 - x;
+		y = s - 1 - y;
+	  }
+	  std::swap(x, y);
+	}
+  }
+  return d;
+}
+
+class Triangulator {
+ public:
+  explicit Triangulator(const std::vector<dvec2>& input) : points{ input } {
+	auto lower = input.front();
+	auto upper = input.front();
+	for (const auto& p : input) {
+	  lower = min(lower, p);
+	  upper = max(upper, p);
+	}
+
+	// a super triangle far enough away that it does not disturb the hull of the input
+	const auto center = (lower + upper) / 2.0;
+	const auto extent = std::max({ upper.x - lower.x, upper.y - lower.y, 1e-9 }) * 20.0;
+	superBegin = static_cast<std::uint32_t>(points.size());
+	points.push_back(center + dvec2{ -extent, -extent });
+	points.push_back(center + dvec2{ extent, -extent });
+	points.push_back(center + dvec2{ 0.0, extent });
+	tris.push_back({ { superBegin, superBegin + 1, superBegin + 2 }, { none, none, none } });
+
+	std::vector<std::uint32_t> order(input.size());
+	std::iota(begin(order), end(order), 0u);
+	std::vector<std::uint32_t> keys(input.size());
+	const auto scale = 65535.0 / std::max({ upper.x - lower.x, upper.y - lower.y, 1e-9 });
+	for (std::size_t i = 0; i < input.size(); i++) {
+	  const auto q = (input[i] - lower) * scale;
+	  keys[i] = hilbertIndex(static_cast<std::uint32_t>(q.x), static_cast<std::uint32_t>(q.y));
+	}
+	std::sort(begin(order), end(order), [&](std::uint32_t a, std::uint32_t b) {
+	  return keys[a] < keys[b];
+	});
+
+	for (const auto i : order)
+	  insert(i);
+  }
+
+  std::vector<std::array<std::uint32_t, 3>> result() const {
+	std::vector<std::array<std::uint32_t, 3>> out;
+	out.reserve(tris.size());
+	for (const auto& t : tris)
+	  if (t.v[0] < superBegin && t.v[1] < superBegin && t.v[2] < superBegin)
+		out.push_back(t.v);
+	return out;
+  }
+
+ private:
+  void replaceNeighbor(std::uint32_t t, std::uint32_t from, std::uint32_t to) {
+	if (t == none) return;
+	for (auto& n : tris[t].n)
+	  if (n == from) n = to;
+  }
+
+  // Walks from the last inserted triangle towards p. Sets edge to the index of the vertex opposite of the edge p lies
+  // on, or -1 if p is strictly inside.
+  std::uint32_t locate(dvec2 p, int& edge) {
+	auto t = last;
+	for (;;) {
+	  const auto& tri = tris[t];
+	  auto moved = false;
+	  edge = -1;
+	  // starting at a rotating edge keeps the walk from cycling on degenerate input
+	  walkStart = (walkStart + 1) % 3;
+	  for (auto k = 0; k < 3; k++) {
+		const auto i = (walkStart + k) % 3;
+		const auto o = orient(points[tri.v[(i + 1) % 3]], points[tri.v[(i + 2) % 3]], p);
+		if (o < 0 && tri.n[i] != none) {
+		  t = tri.n[i];
+		  moved = true;
+		  break;
+		}
+		if (o == 0)
+		  edge = i;
+	  }
+	  if (!moved)
+		return t;
+	}
+  }
+
+  void insert(std::uint32_t p) {
+	int edge;
+	const auto t = locate(points[p], edge);
+	for (const auto v : tris[t].v)
+	  if (points[v] == points[p])
+		return;
+
+	if (edge >= 0 && tris[t].n[edge] != none)
+	  splitEdge(t, edge, p);
+	else
+	  splitTriangle(t, p);
+
+	while (!pending.empty()) {
+	  const auto e = pending.back();
+	  pending.pop_back();
+	  legalize(e);
+	}
+  }
+
+  void splitTriangle(std::uint32_t t, std::uint32_t p) {
+	const auto [a, b, c] = tris[t].v;
+	const auto [na, nb, nc] = tris[t].n;
+	const auto tb = static_cast<std::uint32_t>(tris.size());
+	const auto tc = tb + 1;
+
+	tris[t] = { { p, b, c }, { na, tb, tc } };
+	tris.push_back({ { p, c, a }, { nb, tc, t } });
+	tris.push_back({ { p, a, b }, { nc, t, tb } });
+	replaceNeighbor(nb, t, tb);
+	replaceNeighbor(nc, t, tc);
+
+	last = t;
+	pending.insert(end(pending), { t, tb, tc });
+  }
+
+  // p lies on the edge opposite of vertex i of t, split both triangles sharing that edge
+  void splitEdge(std::uint32_t t, int i, std::uint32_t p) {
+	const auto a = tris[t].v[i];
+	const auto b = tris[t].v[(i + 1) % 3];
+	const auto c = tris[t].v[(i + 2) % 3];
+	const auto nb = tris[t].n[(i + 1) % 3];
+	const auto nc = tris[t].n[(i + 2) % 3];
+
+	const auto o = tris[t].n[i];
+	auto j = 0;
+	while (tris[o].n[j] != t) j++;
+	const auto d = tris[o].v[j];
+	const auto oc = tris[o].n[(j + 1) % 3];
+	const auto ob = tris[o].n[(j + 2) % 3];
+
+	const auto t2 = static_cast<std::uint32_t>(tris.size());
+	const auto t4 = t2 + 1;
+	tris[t] = { { p, c, a }, { nb, t2, t4 } };
+	tris.push_back({ { p, a, b }, { nc, o, t } });
+	tris[o] = { { p, b, d }, { oc, t4, t2 } };
+	tris.push_back({ { p, d, c }, { ob, t, o } });
+	replaceNeighbor(nc, t, t2);
+	replaceNeighbor(ob, o, t4);
+
+	last = t;
+	pending.insert(end(pending), { t, t2, o, t4 });
+  }
+
+  // t has the newly inserted point at v[0], flip the opposite edge if it is not locally Delaunay
+  void legalize(std::uint32_t t) {
+	const auto o = tris[t].n[0];
+	if (o == none) return;
+
+	auto j = 0;
+	while (tris[o].n[j] != t) j++;
+	const auto [p, v1, v2] = tris[t].v;
+	const auto d = tris[o].v[j];
+	if (inCircle(points[p], points[v1], points[v2], points[d]) <= 0)
+	  return;
+
+	const auto n1 = tris[t].n[1];
+	const auto n2 = tris[t].n[2];
+	const auto oV1D = tris[o].n[(j + 1) % 3];
+	const auto oDV2 = tris[o].n[(j + 2) % 3];
+
+	tris[t] = { { p, v1, d }, { oV1D, o, n2 } };
+	tris[o] = { { p, d, v2 }, { oDV2, n1, t } };
+	replaceNeighbor(oV1D, o, t);
+	replaceNeighbor(n1, t, o);
+
+	pending.insert(end(pending), { t, o });
+  }
+
+  std::vector<dvec2> points;
+  std::vector<Tri> tris;
+  std::vector<std::uint32_t> pending;
+  std::uint32_t superBegin = 0;
+  std::uint32_t last = 0;
+  int walkStart = 0;
+};
+
+}// namespace
+
+std::vector<std::array<std::uint32_t, 3>> delaunay2d(const std::vector<dvec2>& points) {
+  if (points.size() < 3)
+	return {};
+  return Triangulator{ points }.result();
+}
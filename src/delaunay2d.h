@@ -0,0 +1,11 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Planar Delaunay triangulation of a point set. Returns counter-clockwise triangles as indices into points.
+// Duplicate points are skipped, so some indices may not appear in the result.
+std::vector<std::array<std::uint32_t, 3>> delaunay2d(const std::vector<glm::dvec2>& points);
@@ -0,0 +1,91 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <iostream>
+#include <numeric>
+#include <vector>
+
+#include <glad/glad.h>
+
+// CPU and GPU time of every frame between begin and end. The CPU time is what the loop takes to submit the frame, the
+// GPU time comes from a GL_TIME_ELAPSED query when the context has timer queries. Queries are read back `latency`
+// frames later, by then the GPU is done with them and reading does not stall the pipeline.
+class FrameTimer {
+ public:
+  FrameTimer() : gpuTimers(GLAD_GL_VERSION_3_3 || GLAD_GL_ARB_timer_query) {
+	if (gpuTimers)
+	  glGenQueries(static_cast<GLsizei>(queries.size()), queries.data());
+  }
+
+  ~FrameTimer() {
+	if (gpuTimers)
+	  glDeleteQueries(static_cast<GLsizei>(queries.size()), queries.data());
+  }
+
+  FrameTimer(const FrameTimer&) = delete;
+  FrameTimer& operator=(const FrameTimer&) = delete;
+
+  void begin() {
+	if (gpuTimers) {
+	  // the query of this slot was issued `latency` frames ago
+	  if (frames >= latency)
+		readQuery(frames % latency);
+	  glBeginQuery(GL_TIME_ELAPSED, queries[frames % latency]);
+	}
+	cpuStart = std::chrono::high_resolution_clock::now();
+  }
+
+  void end() {
+	const auto cpuEnd = std::chrono::high_resolution_clock::now();
+	cpuMs.push_back(std::chrono::duration<double, std::milli>(cpuEnd - cpuStart).count());
+	if (gpuTimers)
+	  glEndQuery(GL_TIME_ELAPSED);
+	frames++;
+  }
+
+  std::size_t frameCount() const {
+	return frames;
+  }
+
+  // waits for the queries still in flight
+  void report(std::ostream& out) {
+	if (gpuTimers) {
+	  for (auto frame = frames > latency ? frames - latency : 0; frame < frames; frame++)
+		readQuery(frame % latency);
+	}
+	out << "[  FRAMES  ] " << frames << " frames\n";
+	printStats(out, "CPU", cpuMs);
+	if (gpuTimers)
+	  printStats(out, "GPU", gpuMs);
+	else
+	  out << "             GPU timer queries not available\n";
+  }
+
+ private:
+  static constexpr std::size_t latency = 4;
+
+  void readQuery(std::size_t slot) {
+	GLuint64 nanoseconds = 0;
+	glGetQueryObjectui64v(queries[slot], GL_QUERY_RESULT, &nanoseconds);
+	gpuMs.push_back(static_cast<double>(nanoseconds) / 1e6);
+  }
+
+  static void printStats(std::ostream& out, const char* name, std::vector<double> ms) {
+	if (ms.empty())
+	  return;
+	std::sort(ms.begin(), ms.end());
+	const auto mean = std::accumulate(ms.begin(), ms.end(), 0.0) / static_cast<double>(ms.size());
+	const auto percentile = [&](double p) { return ms[static_cast<std::size_t>(p * static_cast<double>(ms.size() - 1))]; };
+	out << "             " << name << " ms mean: " << mean << " median: " << percentile(0.5) << " p95: " << percentile(0.95) << " p99: " << percentile(0.99) << " max: " << ms.back() << '\n';
+  }
+
+  bool gpuTimers;
+  std::array<GLuint, latency> queries{};
+  std::size_t frames = 0;
+  std::chrono::high_resolution_clock::time_point cpuStart;
+  std::vector<double> cpuMs;
+  std::vector<double> gpuMs;
+};
@@ -1,5 +1,8 @@
 #pragma once
 
+#include <iostream>
+#include <optional>
+
 #include <glad/glad.h>
 
 #include "window.h"
@@ -35,9 +38,36 @@ inline void createGBuffer(unsigned int& gBuffer, unsigned int& gPosition, unsign
   glDrawBuffers(3, attachments);
 }
 
-inline void createRenderBuffer(unsigned int rboDepth) {
+// Depth and stencil in the format Window asks for the default framebuffer, since depth is only blitted between
+// framebuffers of the same format.
+inline void createRenderBuffer(unsigned int& rboDepth) {
   glGenRenderbuffers(1, &rboDepth);
   glBindRenderbuffer(GL_RENDERBUFFER, rboDepth);
-  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT, SCREEN_WIDTH, SCREEN_HEIGHT);
-  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
+  glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, SCREEN_WIDTH, SCREEN_HEIGHT);
+  glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, rboDepth);
+}
+
+// G-buffer with a depth attachment, the render target of the headless mode where there is no default framebuffer to
+// look at. Only the RGBA8 albedo attachment is drawn to, the forward shaders write their color there, so the frame
+// times measure the same bandwidth as the window's color buffer rather than three targets, two of them half float.
+struct OffscreenTarget {
+  unsigned int framebuffer = 0;
+  unsigned int position = 0;
+  unsigned int normal = 0;
+  unsigned int albedoSpec = 0;
+  unsigned int depth = 0;
+};
+
+inline std::optional<OffscreenTarget> createOffscreenTarget() {
+  OffscreenTarget target;
+  createGBuffer(target.framebuffer, target.position, target.normal, target.albedoSpec);
+  glDrawBuffer(GL_COLOR_ATTACHMENT2);
+  createRenderBuffer(target.depth);
+  const auto status = glCheckFramebufferStatus(GL_FRAMEBUFFER);
+  glBindFramebuffer(GL_FRAMEBUFFER, 0);
+  if (status != GL_FRAMEBUFFER_COMPLETE) {
+	std::cerr << "Offscreen framebuffer incomplete: " << status << '\n';
+	return {};
+  }
+  return target;
 }
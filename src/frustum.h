@@ -0,0 +1,23 @@
+#pragma once
+
+#include <array>
+
+#include <glm/glm.hpp>
+
+#include "aabb.h"
+
+// The six planes of a view frustum, pointing inwards, as (normal, distance) so that dot(normal, p) + distance >= 0 inside.
+struct Frustum {
+  // Gribb and Hartmann: the planes are sums and differences of the rows of the projection matrix, in the space the
+  // matrix transforms from
+  explicit Frustum(const glm::mat4& viewProjection) {
+	const auto row = [&](int r) { return glm::vec4{ viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r] }; };
+	planes = { row(3) + row(0), row(3) - row(0), row(3) + row(1), row(3) - row(1), row(3) + row(2), row(3) - row(2) };
+  }
+
+  bool intersects(glm::vec3 lower, glm::vec3 upper) const {
+	return AABB{ upper, lower }.intersects(planes);
+  }
+
+  std::array<glm::vec4, 6> planes;
+};
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+// Fast non-cryptographic 64 bit hash over raw bytes. Good enough to key caches, not to resist attackers.
+inline std::uint64_t hashMix(std::uint64_t h) {
+  h ^= h >> 30;
+  h *= 0xbf58476d1ce4e5b9ull;
+  h ^= h >> 27;
+  h *= 0x94d049bb133111ebull;
+  h ^= h >> 31;
+  return h;
+}
+
+inline std::uint64_t hashBytes(const void* data, std::size_t size, std::uint64_t seed = 0) {
+  const auto* bytes = static_cast<const unsigned char*>(data);
+  auto h = hashMix(seed ^ (size * 0x9e3779b97f4a7c15ull));
+
+  std::size_t i = 0;
+  for (; i + 8 <= size; i += 8) {
+	std::uint64_t word;
+	std::memcpy(&word, bytes + i, 8);
+	h = std::rotl(h ^ hashMix(word), 29) * 0x9e3779b97f4a7c15ull;
+  }
+
+  std::uint64_t tail = 0;
+  if (size - i > 0)
+	std::memcpy(&tail, bytes + i, size - i);
+  return hashMix(h ^ tail);
+}
+
+inline std::uint64_t hashCombine(std::uint64_t a, std::uint64_t b) {
+  return hashMix(a ^ std::rotl(b, 17) ^ 0x9e3779b97f4a7c15ull);
+}
@@ -0,0 +1,140 @@
+#include "hole_filling.h"
+
+#include <algorithm>
+#include <unordered_map>
+#include <unordered_set>
+
+#include "parallel.h"
+#include "spatial_index.h"
+
+using namespace glm;
+
+namespace {
+auto edgeKey(PointId a, PointId b) -> std::uint64_t {
+  return static_cast<std::uint64_t>(a) << 32 | b;
+}
+
+// Boundary loops as vertex sequences in the direction of the boundary edges, that is the winding of the adjacent
+// triangles. Loops that visit a vertex twice are reported as empty.
+auto traceLoops(const std::vector<IndexedTriangle>& faces, std::uint32_t maxLoopEdges, HoleFillingStats& stats) -> std::vector<std::vector<PointId>> {
+  std::unordered_set<std::uint64_t> halfEdges;
+  halfEdges.reserve(faces.size() * 3);
+  for (const auto& f : faces)
+	for (auto i = 0; i < 3; i++)
+	  halfEdges.insert(edgeKey(f[i], f[(i + 1) % 3]));
+
+  // boundary edges in face order so the loops come out the same every run
+  std::vector<std::pair<PointId, PointId>> boundary;
+  std::unordered_map<PointId, std::vector<std::uint32_t>> outgoing;
+  for (const auto& f : faces) {
+	for (auto i = 0; i < 3; i++) {
+	  const auto a = f[i];
+	  const auto b = f[(i + 1) % 3];
+	  if (halfEdges.contains(edgeKey(b, a))) continue;
+	  outgoing[a].push_back(static_cast<std::uint32_t>(boundary.size()));
+	  boundary.emplace_back(a, b);
+	}
+  }
+
+  std::vector<bool> used(boundary.size());
+  std::vector<std::vector<PointId>> loops;
+  std::unordered_set<PointId> visited;
+  for (std::uint32_t start = 0; start < boundary.size(); start++) {
+	if (used[start]) continue;
+	std::vector<PointId> loop;
+	visited.clear();
+	auto simple = true;
+	auto edge = start;
+	while (true) {
+	  used[edge] = true;
+	  const auto [a, b] = boundary[edge];
+	  loop.push_back(a);
+	  simple = simple && visited.insert(a).second;
+	  if (b == boundary[start].first) break;
+	  const auto& candidates = outgoing[b];
+	  const auto next = std::find_if(begin(candidates), end(candidates), [&](std::uint32_t e) { return !used[e]; });
+	  if (next == end(candidates)) {
+		simple = false;
+		break;
+	  }
+	  edge = *next;
+	}
+	if (simple && loop.size() >= 3 && loop.size() <= maxLoopEdges)
+	  loops.push_back(std::move(loop));
+	else
+	  stats.skipped++;
+  }
+  return loops;
+}
+
+// Ear clipping of a loop projected onto the plane of its Newell normal. The loop is walked backwards, so the new
+// triangles use the boundary edges in the opposite direction of the triangles already there.
+void clipEars(std::span<const Point> points, std::vector<PointId> loop, std::vector<IndexedTriangle>& out) {
+  std::reverse(begin(loop), end(loop));
+
+  vec3 normal{};
+  for (std::size_t i = 0; i < loop.size(); i++) {
+	const auto p = points[loop[i]].pos;
+	const auto q = points[loop[(i + 1) % loop.size()]].pos;
+	normal += vec3{ (p.y - q.y) * (p.z + q.z), (p.z - q.z) * (p.x + q.x), (p.x - q.x) * (p.y + q.y) };
+  }
+  if (dot(normal, normal) == 0)
+	normal = vec3{ 0, 0, 1 };
+  normal = normalize(normal);
+  const auto u = normalize(std::abs(normal.x) < 0.9f ? cross(normal, vec3{ 1, 0, 0 }) : cross(normal, vec3{ 0, 1, 0 }));
+  const auto v = cross(normal, u);
+
+  std::vector<vec2> projected(loop.size());
+  std::transform(begin(loop), end(loop), begin(projected), [&](PointId p) { return vec2{ dot(points[p].pos, u), dot(points[p].pos, v) }; });
+  const auto cross2 = [](vec2 a, vec2 b) { return a.x * b.y - a.y * b.x; };
+
+  // indices into loop of the vertices not clipped yet
+  std::vector<std::size_t> remaining(loop.size());
+  for (std::size_t i = 0; i < remaining.size(); i++)
+	remaining[i] = i;
+
+  while (remaining.size() > 3) {
+	const auto n = remaining.size();
+	auto ear = n;
+	for (std::size_t i = 0; i < n && ear == n; i++) {
+	  const auto prev = projected[remaining[(i + n - 1) % n]];
+	  const auto cur = projected[remaining[i]];
+	  const auto next = projected[remaining[(i + 1) % n]];
+	  if (cross2(cur - prev, next - cur) <= 0) continue;
+	  auto empty = true;
+	  for (std::size_t j = 0; j < n && empty; j++) {
+		if (j == i || j == (i + n - 1) % n || j == (i + 1) % n) continue;
+		const auto p = projected[remaining[j]];
+		empty = !(cross2(cur - prev, p - prev) > 0 && cross2(next - cur, p - cur) > 0 && cross2(prev - next, p - next) > 0);
+	  }
+	  if (empty)
+		ear = i;
+	}
+	// the projection of a strongly curved loop need not be simple, then there is no proper ear and any vertex will do
+	if (ear == n)
+	  ear = 0;
+	out.push_back({ loop[remaining[(ear + n - 1) % n]], loop[remaining[ear]], loop[remaining[(ear + 1) % n]] });
+	remaining.erase(begin(remaining) + static_cast<std::ptrdiff_t>(ear));
+  }
+  out.push_back({ loop[remaining[0]], loop[remaining[1]], loop[remaining[2]] });
+}
+}
+
+std::vector<IndexedTriangle> fillHoles(std::span<const Point> points, const std::vector<IndexedTriangle>& faces, std::uint32_t maxLoopEdges, HoleFillingStats* stats) {
+  HoleFillingStats local;
+  const auto loops = traceLoops(faces, maxLoopEdges, local);
+  local.filled = loops.size();
+  if (stats)
+	*stats = local;
+
+  std::vector<std::vector<IndexedTriangle>> patches(loops.size());
+  parallelFor(loops.size(), 16, false, [&](std::size_t from, std::size_t to) {
+	for (auto i = from; i < to; i++)
+	  clipEars(points, loops[i], patches[i]);
+  });
+
+  std::vector<IndexedTriangle> result;
+  for (const auto& patch : patches)
+	result.insert(end(result), begin(patch), end(patch));
+  return result;
+}
@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+#include <span>
+#include <vector>
+
+#include "bpa.h"
+
+struct HoleFillingStats {
+  std::size_t filled = 0;
+  // too large, or not a simple loop (pinched at a vertex)
+  std::size_t skipped = 0;
+};
+
+// Closes the small holes ball pivoting leaves where the sampling was too sparse for the radius, without reconstructing
+// again with a larger ball. Boundary loops are traced from the edges that only one triangle uses; loops of at most
+// maxLoopEdges edges are triangulated by ear clipping in the plane of the loop, in parallel across loops. Larger loops,
+// like the border of an open scan, are left alone. Returns only the new triangles, wound consistently with the mesh.
+std::vector<IndexedTriangle> fillHoles(std::span<const Point> points, const std::vector<IndexedTriangle>& faces, std::uint32_t maxLoopEdges, HoleFillingStats* stats = nullptr);
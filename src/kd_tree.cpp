@@ -0,0 +1,111 @@
+#include "kd_tree.h"
+
+#include <algorithm>
+
+#include <glm/gtx/norm.hpp>
+
+#include <tbb/parallel_invoke.h>
+
+using namespace glm;
+
+// ranges this small are scanned linearly
+constexpr std::size_t leafSize = 8;
+// below this the subtrees are built on the current thread
+constexpr std::size_t parallelBuildSize = 1 << 15;
+
+KdTree::KdTree(std::vector<Neighbor> points)
+  : nodes(std::move(points)), axes(nodes.size()) {
+  build(0, nodes.size());
+}
+
+void KdTree::build(std::size_t begin, std::size_t end) {
+  if (end - begin <= leafSize)
+	return;
+
+  vec3 lower = nodes[begin].pos;
+  vec3 upper = nodes[begin].pos;
+  for (auto i = begin + 1; i < end; i++) {
+	lower = min(lower, nodes[i].pos);
+	upper = max(upper, nodes[i].pos);
+  }
+  const auto extent = upper - lower;
+  const auto axis = extent.x >= extent.y && extent.x >= extent.z ? 0 : (extent.y >= extent.z ? 1 : 2);
+
+  // ties go by id so the tree does not depend on the nth_element implementation
+  const auto mid = begin + (end - begin) / 2;
+  std::nth_element(nodes.begin() + static_cast<std::ptrdiff_t>(begin), nodes.begin() + static_cast<std::ptrdiff_t>(mid), nodes.begin() + static_cast<std::ptrdiff_t>(end), [&](const Neighbor& a, const Neighbor& b) {
+	return a.pos[axis] < b.pos[axis] || (a.pos[axis] == b.pos[axis] && a.id < b.id);
+  });
+  axes[mid] = static_cast<std::uint8_t>(axis);
+
+  if (end - begin > parallelBuildSize)
+	tbb::parallel_invoke([&] { build(begin, mid); }, [&] { build(mid + 1, end); });
+  else {
+	build(begin, mid);
+	build(mid + 1, end);
+  }
+}
+
+void KdTree::radiusQuery(vec3 center, float radius, std::initializer_list<vec3> ignore, std::vector<Neighbor>& result) const {
+  result.clear();
+  appendRadiusQuery(center, radius, ignore, result);
+}
+
+void KdTree::appendRadiusQuery(vec3 center, float radius, std::initializer_list<vec3> ignore, std::vector<Neighbor>& result) const {
+  const auto radius2 = radius * radius;
+  const auto visit = [&](const Neighbor& n) {
+	if (withinRadius(n.pos, center, radius) && std::find(ignore.begin(), ignore.end(), n.pos) == ignore.end())
+	  result.push_back(n);
+  };
+
+  struct Range {
+	std::size_t begin;
+	std::size_t end;
+  };
+  // depth is logarithmic, a small fixed stack is enough
+  Range stack[64];
+  auto top = 0;
+  stack[top++] = { 0, nodes.size() };
+  while (top > 0) {
+	const auto [begin, end] = stack[--top];
+	if (end - begin <= leafSize) {
+	  for (auto i = begin; i < end; i++)
+		visit(nodes[i]);
+	  continue;
+	}
+
+	const auto mid = begin + (end - begin) / 2;
+	const auto& node = nodes[mid];
+	visit(node);
+	const auto axis = axes[mid];
+	const auto offset = center[axis] - node.pos[axis];
+	const Range left{ begin, mid };
+	const Range right{ mid + 1, end };
+	// the near side goes on top of the stack so it is visited first
+	if (offset * offset < radius2)
+	  stack[top++] = offset < 0 ? right : left;
+	stack[top++] = offset < 0 ? left : right;
+  }
+}
+
+void KdForest::insert(PointId begin, PointId end, const std::function<vec3(PointId)>& position, const std::function<vec3(PointId)>& normal) {
+  if (begin == end)
+	return;
+  std::vector<Neighbor> points;
+  points.reserve(end - begin);
+  for (auto id = begin; id < end; id++)
+	points.push_back({ position(id), normal(id), id });
+  // the trees are kept largest first, the smaller ones at the back are merged into the new tree
+  while (!trees.empty() && trees.back().size() <= points.size()) {
+	const auto& merged = trees.back().points();
+	points.insert(points.end(), merged.begin(), merged.end());
+	trees.pop_back();
+  }
+  trees.emplace_back(std::move(points));
+}
+
+void KdForest::radiusQuery(vec3 center, float radius, std::initializer_list<vec3> ignore, std::vector<Neighbor>& result) const {
+  result.clear();
+  for (const auto& tree : trees)
+	tree.appendRadiusQuery(center, radius, ignore, result);
+}
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+#include "spatial_index.h"
+
+// Implicit k-d tree: the points are stored in tree order, every range [begin, end) has its splitting point in the
+// middle and the two halves as subtrees, so there are no node pointers and a subtree is one contiguous block of memory.
+// Unlike the uniform grid it adapts to the local density, a dense wall and a sparse ceiling cost the same per query.
+class KdTree : public SpatialIndex {
+ public:
+  // the points with their positions and normals as the reconstruction sees them
+  explicit KdTree(std::vector<Neighbor> points);
+
+  void radiusQuery(glm::vec3 center, float radius, std::initializer_list<glm::vec3> ignore, std::vector<Neighbor>& result) const override;
+  // like radiusQuery, but appends to result
+  void appendRadiusQuery(glm::vec3 center, float radius, std::initializer_list<glm::vec3> ignore, std::vector<Neighbor>& result) const;
+
+  std::size_t size() const { return nodes.size(); }
+  // the points in tree order, to merge trees
+  const std::vector<Neighbor>& points() const { return nodes; }
+
+ private:
+  void build(std::size_t begin, std::size_t end);
+
+  std::vector<Neighbor> nodes;
+  // splitting axis of the node in the middle of each inner range
+  std::vector<std::uint8_t> axes;
+};
+
+// Implicit trees cannot take more points, so a growing cloud is kept as a few of them with sizes falling roughly by
+// half (the logarithmic method). Inserting builds a tree of the new points and merges it with every tree that is not
+// larger, so each point is rebuilt into a larger tree only a logarithmic number of times.
+class KdForest : public SpatialIndex {
+ public:
+  // adds the points [begin, end)
+  void insert(PointId begin, PointId end, const std::function<glm::vec3(PointId)>& position, const std::function<glm::vec3(PointId)>& normal);
+
+  void radiusQuery(glm::vec3 center, float radius, std::initializer_list<glm::vec3> ignore, std::vector<Neighbor>& result) const override;
+
+ private:
+  std::vector<KdTree> trees;
+};
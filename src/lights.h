@@ -0,0 +1,103 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+// CPU mirrors of the LightBlock uniform block of basic.fs.glsl in std140 layout, where every vec3 takes 16 bytes. The
+// paddings are zeroed so blocks can be compared bytewise.
+struct DirLightData {
+  glm::vec3 direction;
+  float padding0 = 0.0f;
+  glm::vec3 ambient;
+  float padding1 = 0.0f;
+  glm::vec3 diffuse;
+  float padding2 = 0.0f;
+  glm::vec3 specular;
+  float padding3 = 0.0f;
+};
+
+struct PointLightData {
+  glm::vec3 position;
+  float constant;
+  glm::vec3 ambient;
+  float linear;
+  glm::vec3 diffuse;
+  float quadratic;
+  glm::vec3 specular;
+  float padding = 0.0f;
+};
+
+constexpr auto pointLightCount = 4;
+
+struct LightBlock {
+  DirLightData dirLight;
+  std::array<PointLightData, pointLightCount> pointLights;
+  // Material
+  float shininess;
+  float padding[3] = {};
+};
+
+static_assert(sizeof(DirLightData) == 64 && sizeof(PointLightData) == 64 && sizeof(LightBlock) == 336, "must match the std140 layout of LightBlock");
+
+// A point light of the deferred path, drawn as a cube around its light volume (see Renderer::lightingPass). The
+// attenuation is 1 / (1 + linear d + quadratic d^2) like the forward lights with a constant term of 1.
+struct LightVolume {
+  glm::vec3 position;
+  float radius;
+  glm::vec3 color;
+  float linear;
+  float quadratic;
+};
+
+// Distance at which the brightest channel of the light has faded to 5/256, which an 8-bit target no longer shows.
+inline LightVolume makeLightVolume(glm::vec3 position, glm::vec3 color, float linear, float quadratic) {
+  const auto intensity = std::max({ color.r, color.g, color.b });
+  const auto radius = (-linear + std::sqrt(linear * linear - 4.0f * quadratic * (1.0f - 256.0f / 5.0f * intensity))) / (2.0f * quadratic);
+  return { position, radius, color, linear, quadratic };
+}
+
+// Uniform buffer holding the lights and the material for every shader that binds its LightBlock to `binding` (see
+// Shader::bindBlock). The buffer is only written when the lights change, not every frame.
+class LightUniforms {
+ public:
+  static constexpr GLuint binding = 0;
+
+  LightUniforms() {
+	glGenBuffers(1, &ubo);
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferData(GL_UNIFORM_BUFFER, sizeof(LightBlock), nullptr, GL_DYNAMIC_DRAW);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	glBindBufferBase(GL_UNIFORM_BUFFER, binding, ubo);
+  }
+
+  ~LightUniforms() {
+	glDeleteBuffers(1, &ubo);
+  }
+
+  LightUniforms(const LightUniforms&) = delete;
+  LightUniforms& operator=(const LightUniforms&) = delete;
+
+  void update(const LightBlock& lights) {
+	if (uploaded && std::memcmp(&current, &lights, sizeof(LightBlock)) == 0)
+	  return;
+	glBindBuffer(GL_UNIFORM_BUFFER, ubo);
+	glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(LightBlock), &lights);
+	glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	current = lights;
+	uploaded = true;
+  }
+
+  const LightBlock& lights() const {
+	return current;
+  }
+
+ private:
+  GLuint ubo = 0;
+  LightBlock current{};
+  bool uploaded = false;
+};
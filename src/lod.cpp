@@ -0,0 +1,76 @@
+#include "lod.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include "decimate.h"
+#include "frustum.h"
+#include "parallel.h"
+
+using namespace glm;
+
+LodMesh::LodMesh(const std::vector<Triangle>& mesh, const TunnelAxis& axis, const LodOptions& options) {
+  const auto direction = normalize(axis.direction);
+  const auto along = [&](const Triangle& t) { return dot((t[0] + t[1] + t[2]) / 3.0f - axis.origin, direction); };
+
+  auto first = std::numeric_limits<float>::max();
+  auto last = std::numeric_limits<float>::lowest();
+  for (const auto& t : mesh) {
+	first = std::min(first, along(t));
+	last = std::max(last, along(t));
+  }
+  if (mesh.empty())
+	first = last = 0;
+  const auto tileLength = options.tileLength > 0 ? options.tileLength : std::max((last - first) / 32, std::numeric_limits<float>::min());
+  m_levelDistance = options.levelDistance > 0 ? options.levelDistance : 2 * tileLength;
+
+  const auto count = static_cast<std::size_t>((last - first) / tileLength) + 1;
+  std::vector<std::vector<Triangle>> tileTriangles(count);
+  for (const auto& t : mesh)
+	tileTriangles[std::min(static_cast<std::size_t>((along(t) - first) / tileLength), count - 1)].push_back(t);
+  std::erase_if(tileTriangles, [](const std::vector<Triangle>& triangles) { return triangles.empty(); });
+
+  m_tiles.resize(tileTriangles.size());
+  parallelFor(m_tiles.size(), 1, false, [&](std::size_t from, std::size_t to) {
+	for (auto i = from; i < to; i++) {
+	  auto& tile = m_tiles[i];
+	  tile.lower = tile.upper = tileTriangles[i].front()[0];
+	  for (const auto& t : tileTriangles[i]) {
+		for (const auto& v : t) {
+		  tile.lower = min(tile.lower, v);
+		  tile.upper = max(tile.upper, v);
+		}
+	  }
+
+	  tile.levels.push_back(std::move(tileTriangles[i]));
+	  auto indexed = indexMesh(tile.levels.back());
+	  for (std::uint32_t level = 1; level < options.levels; level++) {
+		// the first pass is serial anyway for a single tile, chunks would only pin more vertices
+		indexed = decimate(indexed, { std::max<std::size_t>(indexed.triangles.size() / 4, 1), 0.0f, std::numeric_limits<float>::max() });
+		tile.levels.push_back(toTriangles(indexed));
+	  }
+	}
+  });
+}
+
+std::vector<TileSelection> LodMesh::select(vec3 eye, const mat4& viewProjection) const {
+  const Frustum frustum{ viewProjection };
+  std::vector<std::pair<float, TileSelection>> visible;
+  for (std::uint32_t i = 0; i < m_tiles.size(); i++) {
+	const auto& tile = m_tiles[i];
+	if (!frustum.intersects(tile.lower, tile.upper))
+	  continue;
+	const auto distance = length(clamp(eye, tile.lower, tile.upper) - eye);
+	const auto lastLevel = static_cast<std::uint32_t>(tile.levels.size() - 1);
+	const auto level = distance < m_levelDistance ? 0 : std::min(lastLevel, 1 + static_cast<std::uint32_t>(std::log2(distance / m_levelDistance)));
+	visible.push_back({ distance, { i, level } });
+  }
+  std::sort(begin(visible), end(visible), [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  std::vector<TileSelection> selection;
+  selection.reserve(visible.size());
+  for (const auto& [distance, tile] : visible)
+	selection.push_back(tile);
+  return selection;
+}
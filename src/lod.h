@@ -0,0 +1,49 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bpa.h"
+#include "tunnel.h"
+
+struct LodOptions {
+  // length of a tile along the axis, 0 cuts the mesh into 32 tiles
+  float tileLength = 0.0f;
+  // detail levels per tile, each with about a quarter of the triangles of the one before
+  std::uint32_t levels = 4;
+  // tiles closer than this get the full mesh, every doubling of the distance drops a level; 0 uses two tile lengths
+  float levelDistance = 0.0f;
+};
+
+struct LodTile {
+  glm::vec3 lower;
+  glm::vec3 upper;
+  // levels[0] is the full mesh of the tile
+  std::vector<std::vector<Triangle>> levels;
+};
+
+struct TileSelection {
+  std::uint32_t tile;
+  std::uint32_t level;
+};
+
+// A reconstructed tunnel cut into tiles along its axis, each decimated to a few levels of detail. The border vertices of
+// a tile are never moved by the decimation, so neighboring tiles at different levels still meet without cracks. Nothing
+// here touches the GPU, the renderer uploads the levels it is asked to draw.
+class LodMesh {
+ public:
+  LodMesh(const std::vector<Triangle>& mesh, const TunnelAxis& axis, const LodOptions& options = {});
+
+  // the tiles inside the frustum, nearest first, each with the level for its distance to the eye
+  std::vector<TileSelection> select(glm::vec3 eye, const glm::mat4& viewProjection) const;
+
+  const std::vector<LodTile>& tiles() const {
+	return m_tiles;
+  }
+
+ private:
+  std::vector<LodTile> m_tiles;
+  float m_levelDistance;
+};
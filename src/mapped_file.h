@@ -0,0 +1,56 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Read-only memory mapping of a whole file. Evaluates to false if the file could not be mapped.
+class MappedFile {
+ public:
+  MappedFile() = default;
+  explicit MappedFile(const std::filesystem::path& path) {
+	const auto fd = ::open(path.c_str(), O_RDONLY);
+	if (fd < 0)
+	  return;
+	struct stat info {};
+	if (::fstat(fd, &info) == 0 && info.st_size > 0) {
+	  const auto size = static_cast<std::size_t>(info.st_size);
+	  auto* mapped = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+	  if (mapped != MAP_FAILED) {
+		bytes = static_cast<const std::byte*>(mapped);
+		length = size;
+	  }
+	}
+	::close(fd);
+  }
+
+  MappedFile(const MappedFile&) = delete;
+  MappedFile& operator=(const MappedFile&) = delete;
+
+  MappedFile(MappedFile&& other) noexcept
+	: bytes{ std::exchange(other.bytes, nullptr) }, length{ std::exchange(other.length, 0) } {}
+
+  MappedFile& operator=(MappedFile&& other) noexcept {
+	std::swap(bytes, other.bytes);
+	std::swap(length, other.length);
+	return *this;
+  }
+
+  ~MappedFile() {
+	if (bytes)
+	  ::munmap(const_cast<std::byte*>(bytes), length);
+  }
+
+  const std::byte* data() const { return bytes; }
+  std::size_t size() const { return length; }
+  explicit operator bool() const { return bytes != nullptr; }
+
+ private:
+  const std::byte* bytes = nullptr;
+  std::size_t length = 0;
+};
@@ -4,10 +4,15 @@
 
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
+#include <glm/gtc/packing.hpp>
 
 #include "shader.h"
 
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
 #include <string>
+#include <utility>
 #include <vector>
 
 #define MAX_BONE_INFLUENCE 4
@@ -24,11 +29,55 @@ struct Vertex {
   // bitangent
   glm::vec3 Bitangent;
   // bone indexes which will influence this vertex
-  int m_BoneIDs[MAX_BONE_INFLUENCE];
+  int m_BoneIDs[MAX_BONE_INFLUENCE] = { -1, -1, -1, -1 };
   // weights from each bone
-  float m_Weights[MAX_BONE_INFLUENCE];
+  float m_Weights[MAX_BONE_INFLUENCE] = {};
 };
 
+// Vertex is what the importer fills in, the GPU only ever sees one of the packed layouts below. Normal and tangent
+// are snorm 10_10_10_2 with the bitangent sign in the tangent's w, texture coordinates are half floats, and only
+// meshes with bones carry the skin data.
+enum class VertexFormat { Static, Skinned };
+
+struct StaticVertex {
+  glm::vec3 Position;
+  std::uint32_t Normal;
+  std::uint32_t Tangent;
+  std::uint32_t TexCoords;
+};
+
+struct SkinnedVertex {
+  StaticVertex Base;
+  // up to 256 bones per mesh
+  std::uint8_t m_BoneIDs[MAX_BONE_INFLUENCE];
+  // unorm bytes, close enough to the float weights for blending
+  std::uint8_t m_Weights[MAX_BONE_INFLUENCE];
+};
+
+static_assert(sizeof(StaticVertex) == 24);
+static_assert(sizeof(SkinnedVertex) == 32);
+
+inline StaticVertex packVertex(const Vertex& vertex) {
+  // the bitangent is rebuilt in the shader as cross(normal, tangent) * w
+  const auto handedness = glm::dot(glm::cross(vertex.Normal, vertex.Tangent), vertex.Bitangent) < 0.0f ? -1.0f : 1.0f;
+  return {
+	vertex.Position,
+	glm::packSnorm3x10_1x2(glm::vec4(vertex.Normal, 0.0f)),
+	glm::packSnorm3x10_1x2(glm::vec4(vertex.Tangent, handedness)),
+	glm::packHalf2x16(vertex.TexCoords),
+  };
+}
+
+inline SkinnedVertex packSkinnedVertex(const Vertex& vertex) {
+  SkinnedVertex packed{ packVertex(vertex), {}, {} };
+  for (int i = 0; i < MAX_BONE_INFLUENCE; i++) {
+	// unused influences point at bone 0 with no weight
+	packed.m_BoneIDs[i] = static_cast<std::uint8_t>(vertex.m_BoneIDs[i] < 0 ? 0 : vertex.m_BoneIDs[i]);
+	packed.m_Weights[i] = static_cast<std::uint8_t>(std::round(glm::clamp(vertex.m_Weights[i], 0.0f, 1.0f) * 255.0f));
+  }
+  return packed;
+}
+
 struct Texture {
   unsigned int id;
   std::string type;
@@ -41,13 +90,15 @@ class Mesh {
   std::vector<Vertex> vertices;
   std::vector<unsigned int> indices;
   std::vector<Texture> textures;
+  VertexFormat format;
   unsigned int VAO;
 
   // constructor
-  Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures) {
-	this->vertices = vertices;
-	this->indices = indices;
-	this->textures = textures;
+  Mesh(std::vector<Vertex> vertices, std::vector<unsigned int> indices, std::vector<Texture> textures, VertexFormat format = VertexFormat::Static) {
+	this->format = format;
+	this->vertices = std::move(vertices);
+	this->indices = std::move(indices);
+	this->textures = std::move(textures);
 
 	// now that we have all the required data, set the vertex buffers and its attribute pointers.
 	setupMesh();
@@ -74,8 +125,8 @@ class Mesh {
 	  else if (name == "texture_height")
 		number = std::to_string(heightNr++);// transfer unsigned int to std::string
 
-	  // now set the sampler to the correct texture unit
-	  glUniform1i(glGetUniformLocation(shader.ID, (name + number).c_str()), i);
+	  // now set the sampler to the correct texture unit, the location comes from the shader's cache
+	  shader.setInt(name + number, static_cast<int>(i));
 	  // and finally bind the texture
 	  glBindTexture(GL_TEXTURE_2D, textures[i].id);
 	}
@@ -92,6 +143,15 @@ class Mesh {
   // render data
   unsigned int VBO, EBO;
 
+  template <typename Pack>
+  void uploadVertices(Pack pack) {
+	std::vector<decltype(pack(vertices.front()))> packed;
+	packed.reserve(vertices.size());
+	for (const auto& vertex : vertices)
+	  packed.push_back(pack(vertex));
+	glBufferData(GL_ARRAY_BUFFER, packed.size() * sizeof(packed.front()), packed.data(), GL_STATIC_DRAW);
+  }
+
   // initializes all the buffer objects/arrays
   void setupMesh() {
 	// create buffers/arrays
@@ -100,39 +160,40 @@ class Mesh {
 	glGenBuffers(1, &EBO);
 
 	glBindVertexArray(VAO);
-	// load data into vertex buffers
+	// load data into vertex buffers, in the layout of the mesh's format
 	glBindBuffer(GL_ARRAY_BUFFER, VBO);
-	// A great thing about structs is that their memory layout is sequential for all its items.
-	// The effect is that we can simply pass a pointer to the struct and it translates perfectly to a glm::vec3/2 array which
-	// again translates to 3/2 floats which translates to a byte array.
-	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(Vertex), &vertices[0], GL_STATIC_DRAW);
+	const auto stride = static_cast<GLsizei>(format == VertexFormat::Skinned ? sizeof(SkinnedVertex) : sizeof(StaticVertex));
+	if (format == VertexFormat::Skinned)
+	  uploadVertices(packSkinnedVertex);
+	else
+	  uploadVertices(packVertex);
 
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, indices.size() * sizeof(unsigned int), &indices[0], GL_STATIC_DRAW);
 
-	// set the vertex attribute pointers
+	// set the vertex attribute pointers, SkinnedVertex starts with a StaticVertex so the shared ones have the same offsets
 	// vertex Positions
 	glEnableVertexAttribArray(0);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, stride, (void*)0);
 	// vertex normals
 	glEnableVertexAttribArray(1);
-	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Normal));
+	glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(StaticVertex, Normal));
 	// vertex texture coords
 	glEnableVertexAttribArray(2);
-	glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, TexCoords));
-	// vertex tangent
+	glVertexAttribPointer(2, 2, GL_HALF_FLOAT, GL_FALSE, stride, (void*)offsetof(StaticVertex, TexCoords));
+	// vertex tangent, w is the sign of the bitangent which is no longer stored
 	glEnableVertexAttribArray(3);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Tangent));
-	// vertex bitangent
-	glEnableVertexAttribArray(4);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, Bitangent));
-	// ids
-	glEnableVertexAttribArray(5);
-	glVertexAttribIPointer(5, 4, GL_INT, sizeof(Vertex), (void*)offsetof(Vertex, m_BoneIDs));
-
-	// weights
-	glEnableVertexAttribArray(6);
-	glVertexAttribPointer(6, 4, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)offsetof(Vertex, m_Weights));
+	glVertexAttribPointer(3, 4, GL_INT_2_10_10_10_REV, GL_TRUE, stride, (void*)offsetof(StaticVertex, Tangent));
+
+	if (format == VertexFormat::Skinned) {
+	  // ids
+	  glEnableVertexAttribArray(5);
+	  glVertexAttribIPointer(5, 4, GL_UNSIGNED_BYTE, stride, (void*)offsetof(SkinnedVertex, m_BoneIDs));
+
+	  // weights
+	  glEnableVertexAttribArray(6);
+	  glVertexAttribPointer(6, 4, GL_UNSIGNED_BYTE, GL_TRUE, stride, (void*)offsetof(SkinnedVertex, m_Weights));
+	}
 	glBindVertexArray(0);
   }
 };
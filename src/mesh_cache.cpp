@@ -0,0 +1,116 @@
+#include "mesh_cache.h"
+
+#include <array>
+#include <chrono>
+#include <cstring>
+#include <iostream>
+#include <sstream>
+#include <system_error>
+#include <type_traits>
+
+#include "cache_directory.h"
+#include "hash.h"
+#include "mapped_file.h"
+
+namespace fs = std::filesystem;
+
+static_assert(std::is_trivially_copyable_v<Triangle>);
+static_assert(sizeof(Triangle) == 9 * sizeof(float));
+static_assert(sizeof(Point) == 6 * sizeof(float));
+
+// bump whenever the file layout or the meaning of a key changes, so stale entries are never read back
+constexpr std::uint32_t cacheVersion = 2;
+constexpr std::array<char, 8> cacheMagic{ 'B', 'P', 'A', 'M', 'E', 'S', 'H', '\0' };
+
+struct CacheHeader {
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  std::uint32_t triangleSize;
+  std::uint64_t key;
+  std::uint64_t count;
+};
+
+ReconstructionCache::ReconstructionCache(fs::path dir, std::uintmax_t budget)
+  : directory{ std::move(dir) }, budgetBytes{ budget } {
+  std::error_code ec;
+  fs::create_directories(directory, ec);
+  if (ec)
+	std::cerr << "Could not create reconstruction cache at " << directory << ": " << ec.message() << '\n';
+}
+
+fs::path ReconstructionCache::entryPath(std::uint64_t key) const {
+  std::stringstream name;
+  name << std::hex << key << ".mesh";
+  return directory / name.str();
+}
+
+std::optional<CachedMesh> ReconstructionCache::load(std::uint64_t key) {
+  const auto path = entryPath(key);
+  MappedFile file{ path };
+  if (!file || file.size() < sizeof(CacheHeader))
+	return {};
+
+  CacheHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  if (header.magic != cacheMagic || header.version != cacheVersion || header.triangleSize != sizeof(Triangle) || header.key != key
+	  || header.count > (file.size() - sizeof(CacheHeader)) / sizeof(Triangle)
+	  || file.size() != sizeof(CacheHeader) + header.count * sizeof(Triangle)) {
+	std::cerr << "Ignoring corrupt cache entry " << path << '\n';
+	return {};
+  }
+
+  // the mapping is page aligned and the header keeps the triangles aligned to their floats
+  static_assert(sizeof(CacheHeader) % alignof(Triangle) == 0);
+  const auto* triangles = reinterpret_cast<const Triangle*>(file.data() + sizeof(CacheHeader));
+  CachedMesh mesh{ std::move(file), { triangles, static_cast<std::size_t>(header.count) } };
+
+  // the modification time doubles as the LRU timestamp
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+  return mesh;
+}
+
+void ReconstructionCache::store(std::uint64_t key, const std::vector<Triangle>& triangles) {
+  const auto written = writeCacheEntry(entryPath(key), [&](std::ostream& out) {
+	const CacheHeader header{ cacheMagic, cacheVersion, sizeof(Triangle), key, triangles.size() };
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	out.write(reinterpret_cast<const char*>(triangles.data()), static_cast<std::streamsize>(triangles.size() * sizeof(Triangle)));
+  });
+  if (written)
+	evict();
+}
+
+void ReconstructionCache::evict() {
+  evictCacheEntries(directory, ".mesh", budgetBytes);
+}
+
+std::uint64_t reconstructionKey(const std::vector<Point>& points, float radius, const ReconstructionOptions& options) {
+  auto key = hashBytes(points.data(), points.size() * sizeof(Point), cacheVersion);
+  key = hashCombine(key, hashBytes(&radius, sizeof(radius)));
+  key = hashCombine(key, options.deterministic);
+  key = hashCombine(key, options.quantized);
+  key = hashCombine(key, static_cast<std::uint64_t>(options.index));
+  key = hashCombine(key, options.maxHoleEdges);
+  return key;
+}
+
+std::optional<std::vector<Triangle>> loadReconstruction(ReconstructionCache& cache, const std::vector<Point>& points, float radius, const ReconstructionOptions& options) {
+  const auto start = std::chrono::high_resolution_clock::now();
+  const auto cached = cache.load(reconstructionKey(points, radius, options));
+  if (!cached)
+	return {};
+  std::vector<Triangle> mesh(cached->triangles.begin(), cached->triangles.end());
+  const auto end = std::chrono::high_resolution_clock::now();
+  const auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+  std::cerr << "[  CACHED  ] Point: " << points.size() << " Triangles: " << mesh.size() << " Load: " << seconds << "s\n";
+  return mesh;
+}
+
+std::vector<Triangle> cachedReconstruct(ReconstructionCache& cache, const std::vector<Point>& points, float radius, const ReconstructionOptions& options) {
+  if (auto cached = loadReconstruction(cache, points, radius, options))
+	return std::move(*cached);
+
+  auto result = measuredReconstruct(points, radius, options);
+  cache.store(reconstructionKey(points, radius, options), result);
+  return result;
+}
@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <span>
+#include <vector>
+
+#include "bpa.h"
+#include "mapped_file.h"
+
+// A cache entry mapped into memory, the triangles are read straight from the mapping while it is alive.
+struct CachedMesh {
+  MappedFile file;
+  std::span<const Triangle> triangles;
+};
+
+// On-disk cache of reconstructed meshes, keyed by a hash of the input cloud and the reconstruction parameters.
+// Entries are stored as one file each and evicted least recently used first once the directory exceeds its budget.
+class ReconstructionCache {
+ public:
+  ReconstructionCache(std::filesystem::path directory, std::uintmax_t budgetBytes);
+
+  std::optional<CachedMesh> load(std::uint64_t key);
+  void store(std::uint64_t key, const std::vector<Triangle>& triangles);
+
+ private:
+  std::filesystem::path entryPath(std::uint64_t key) const;
+  void evict();
+
+  std::filesystem::path directory;
+  std::uintmax_t budgetBytes;
+};
+
+std::uint64_t reconstructionKey(const std::vector<Point>& points, float radius, const ReconstructionOptions& options = {});
+// The cached mesh of the cloud, if it was reconstructed with these parameters before. The mesh is copied out of the
+// mapping once, the display paths own and replace it.
+std::optional<std::vector<Triangle>> loadReconstruction(ReconstructionCache& cache, const std::vector<Point>& points, float radius, const ReconstructionOptions& options = {});
+std::vector<Triangle> cachedReconstruct(ReconstructionCache& cache, const std::vector<Point>& points, float radius, const ReconstructionOptions& options = {});
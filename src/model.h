@@ -10,27 +10,62 @@
 #include <assimp/postprocess.h>
 
 #include "mesh.h"
+#include "parallel.h"
 #include "shader.h"
+#include "texture_cache.h"
 
 #include <string>
 #include <fstream>
 #include <sstream>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <optional>
+#include <unordered_map>
+#include <utility>
 #include <vector>
 
+// S3TC is not part of the core profile glad was generated for, but every desktop driver exposes it
+#ifndef GL_COMPRESSED_RGB_S3TC_DXT1_EXT
+#define GL_COMPRESSED_RGB_S3TC_DXT1_EXT 0x83F0
+#endif
+#ifndef GL_COMPRESSED_RGBA_S3TC_DXT5_EXT
+#define GL_COMPRESSED_RGBA_S3TC_DXT5_EXT 0x83F3
+#endif
+
+struct StbiDeleter {
+	void operator()(unsigned char* data) const {
+		stbi_image_free(data);
+	}
+};
+
+// pixels of an image file, decoded without a GL context so files can be decoded on any thread
+struct DecodedImage {
+	std::string filename;
+	int width = 0;
+	int height = 0;
+	int components = 0;
+	std::unique_ptr<unsigned char, StbiDeleter> data;
+	// the mip chain from the texture cache, takes the place of data when present
+	std::optional<CompressedTexture> compressed;
+};
+
+DecodedImage DecodeImage(const char* path, const std::string& directory, TextureCache* cache = nullptr);
+unsigned int UploadTexture(const DecodedImage& image);
 unsigned int TextureFromFile(const char* path, const std::string& directory, bool gamma = false);
 
 class Model {
   public:
 	// model data
 	std::vector<Texture> textures_loaded;// stores all the textures loaded so far, optimization to make sure textures aren't loaded more than once.
+	std::unordered_map<std::string, std::size_t> textureIndex;// position in textures_loaded by path as written in the material
 	std::vector<Mesh> meshes;
 	std::string directory;
 	bool gammaCorrection;
+	TextureCache* textureCache;// compressed textures of earlier runs, none if null
 
 	// constructor, expects a filepath to a 3D model.
-	Model(std::string const& path, bool gamma = false) : gammaCorrection(gamma) {
+	Model(std::string const& path, bool gamma = false, TextureCache* cache = &defaultTextureCache()) : gammaCorrection(gamma), textureCache(cache) {
 		loadModel(path);
 	}
 
@@ -55,26 +90,82 @@ class Model {
 		// retrieve the directory path of the filepath
 		directory = path.substr(0, path.find_last_of('/'));
 
+		// every texture file once, decoded in parallel and then uploaded on this thread, which owns the GL context
+		loadTextures(scene);
+
 		// process ASSIMP's root node recursively
-		processNode(scene->mRootNode, scene);
+		std::vector<aiMesh*> sceneMeshes;
+		processNode(scene->mRootNode, scene, sceneMeshes);
+
+		// the vertex data is converted in parallel, only the buffers are created here
+		std::vector<MeshData> data(sceneMeshes.size());
+		parallelFor(sceneMeshes.size(), 1, false, [&](std::size_t begin, std::size_t end) {
+			for (auto i = begin; i < end; i++)
+				data[i] = processMesh(sceneMeshes[i], scene);
+		});
+		meshes.reserve(data.size());
+		for (auto& mesh : data)
+			meshes.emplace_back(std::move(mesh.vertices), std::move(mesh.indices), std::move(mesh.textures), mesh.format);
+	}
+
+	// what a Mesh is made of before its buffers exist
+	struct MeshData {
+		std::vector<Vertex> vertices;
+		std::vector<unsigned int> indices;
+		std::vector<Texture> textures;
+		VertexFormat format = VertexFormat::Static;
+	};
+
+	// the material textures and the sampler names they are bound to, see processMesh
+	static constexpr std::pair<aiTextureType, const char*> textureTypes[] = {
+		{ aiTextureType_DIFFUSE, "texture_diffuse" },
+		{ aiTextureType_SPECULAR, "texture_specular" },
+		{ aiTextureType_HEIGHT, "texture_normal" },
+		{ aiTextureType_AMBIENT, "texture_height" },
+	};
+
+	void loadTextures(const aiScene* scene) {
+		std::vector<Texture> pending;
+		for (unsigned int m = 0; m < scene->mNumMaterials; m++) {
+			const aiMaterial* material = scene->mMaterials[m];
+			for (const auto& [type, typeName] : textureTypes) {
+				for (unsigned int i = 0; i < material->GetTextureCount(type); i++) {
+					aiString str;
+					material->GetTexture(type, i, &str);
+					if (textureIndex.try_emplace(str.C_Str(), textures_loaded.size() + pending.size()).second)
+						pending.push_back({ 0, typeName, str.C_Str() });
+				}
+			}
+		}
+
+		std::vector<DecodedImage> images(pending.size());
+		parallelFor(pending.size(), 1, false, [&](std::size_t begin, std::size_t end) {
+			for (auto i = begin; i < end; i++)
+				images[i] = DecodeImage(pending[i].path.c_str(), directory, textureCache);
+		});
+		if (textureCache)
+			textureCache->evict();
+		for (std::size_t i = 0; i < pending.size(); i++) {
+			pending[i].id = UploadTexture(images[i]);
+			textures_loaded.push_back(pending[i]);
+		}
 	}
 
-	// processes a node in a recursive fashion. Processes each individual mesh located at the node and repeats this process on its children nodes (if any).
-	void processNode(aiNode* node, const aiScene* scene) {
+	// collects the meshes of a node and then of its children, the order in which they are drawn
+	void processNode(aiNode* node, const aiScene* scene, std::vector<aiMesh*>& sceneMeshes) {
 		// process each mesh located at the current node
 		for (unsigned int i = 0; i < node->mNumMeshes; i++) {
 			// the node object only contains indices to index the actual objects in the scene.
 			// the scene contains all the data, node is just to keep stuff organized (like relations between nodes).
-			aiMesh* mesh = scene->mMeshes[node->mMeshes[i]];
-			meshes.push_back(processMesh(mesh, scene));
+			sceneMeshes.push_back(scene->mMeshes[node->mMeshes[i]]);
 		}
 		// after we've processed all of the meshes (if any) we then recursively process each of the children nodes
 		for (unsigned int i = 0; i < node->mNumChildren; i++) {
-			processNode(node->mChildren[i], scene);
+			processNode(node->mChildren[i], scene, sceneMeshes);
 		}
 	}
 
-	Mesh processMesh(aiMesh* mesh, const aiScene* scene) {
+	MeshData processMesh(aiMesh* mesh, const aiScene* scene) const {
 		// data to fill
 		std::vector<Vertex> vertices;
 		std::vector<unsigned int> indices;
@@ -120,6 +211,37 @@ class Model {
 
 			vertices.push_back(vertex);
 		}
+		// skin data, the ids index mesh->mBones and the MAX_BONE_INFLUENCE largest influences of a vertex are kept, a
+		// larger weight replaces the smallest one kept so far
+		if (mesh->HasBones()) {
+			for (unsigned int b = 0; b < mesh->mNumBones; b++) {
+				const aiBone* bone = mesh->mBones[b];
+				for (unsigned int w = 0; w < bone->mNumWeights; w++) {
+					Vertex& vertex = vertices[bone->mWeights[w].mVertexId];
+					const float weight = bone->mWeights[w].mWeight;
+					// free slots have weight 0, influences of weight 0 are not worth a slot
+					int smallest = 0;
+					for (int i = 1; i < MAX_BONE_INFLUENCE; i++) {
+						if (vertex.m_Weights[i] < vertex.m_Weights[smallest])
+							smallest = i;
+					}
+					if (weight > vertex.m_Weights[smallest]) {
+						vertex.m_BoneIDs[smallest] = static_cast<int>(b);
+						vertex.m_Weights[smallest] = weight;
+					}
+				}
+			}
+			// the dropped influences are spread over the kept ones, so the packed weights still sum to 1
+			for (Vertex& vertex : vertices) {
+				float sum = 0.0f;
+				for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+					sum += vertex.m_Weights[i];
+				if (sum > 0.0f) {
+					for (int i = 0; i < MAX_BONE_INFLUENCE; i++)
+						vertex.m_Weights[i] /= sum;
+				}
+			}
+		}
 		// now wak through each of the mesh's faces (a face is a mesh its triangle) and retrieve the corresponding vertex indices.
 		for (unsigned int i = 0; i < mesh->mNumFaces; i++) {
 			aiFace face = mesh->mFaces[i];
@@ -136,85 +258,94 @@ class Model {
 		// specular: texture_specularN
 		// normal: texture_normalN
 
-		// 1. diffuse maps
-		std::vector<Texture> diffuseMaps = loadMaterialTextures(material, aiTextureType_DIFFUSE, "texture_diffuse");
-		textures.insert(textures.end(), diffuseMaps.begin(), diffuseMaps.end());
-		// 2. specular maps
-		std::vector<Texture> specularMaps = loadMaterialTextures(material, aiTextureType_SPECULAR, "texture_specular");
-		textures.insert(textures.end(), specularMaps.begin(), specularMaps.end());
-		// 3. normal maps
-		std::vector<Texture> normalMaps = loadMaterialTextures(material, aiTextureType_HEIGHT, "texture_normal");
-		textures.insert(textures.end(), normalMaps.begin(), normalMaps.end());
-		// 4. height maps
-		std::vector<Texture> heightMaps = loadMaterialTextures(material, aiTextureType_AMBIENT, "texture_height");
-		textures.insert(textures.end(), heightMaps.begin(), heightMaps.end());
-
-		// return a mesh object created from the extracted mesh data
-		return Mesh(vertices, indices, textures);
+		// diffuse, specular, normal and height maps in this order
+		for (const auto& [type, typeName] : textureTypes) {
+			std::vector<Texture> maps = loadMaterialTextures(material, type);
+			textures.insert(textures.end(), maps.begin(), maps.end());
+		}
+
+		// return the data of a mesh, the Mesh is created on the GL thread
+		// the packed bone ids are bytes, a mesh with more bones than that is drawn unskinned
+		const auto format = mesh->HasBones() && mesh->mNumBones <= 256 ? VertexFormat::Skinned : VertexFormat::Static;
+		return { std::move(vertices), std::move(indices), std::move(textures), format };
 	}
 
-	// checks all material textures of a given type and loads the textures if they're not loaded yet.
-	// the required info is returned as a Texture struct.
-	std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type, std::string typeName) {
+	// the textures of a given type of the material, all of them were loaded by loadTextures
+	std::vector<Texture> loadMaterialTextures(aiMaterial* mat, aiTextureType type) const {
 		std::vector<Texture> textures;
 		for (unsigned int i = 0; i < mat->GetTextureCount(type); i++) {
 			aiString str;
 			mat->GetTexture(type, i, &str);
-			// check if texture was loaded before and if so, continue to next iteration: skip loading a new texture
-			bool skip = false;
-			for (unsigned int j = 0; j < textures_loaded.size(); j++) {
-				if (std::strcmp(textures_loaded[j].path.data(), str.C_Str()) == 0) {
-					textures.push_back(textures_loaded[j]);
-					skip = true;// a texture with the same filepath has already been loaded, continue to next one. (optimization)
-					break;
-				}
-			}
-			if (!skip) {// if texture hasn't been loaded already, load it
-				Texture texture;
-				texture.id = TextureFromFile(str.C_Str(), this->directory);
-				texture.type = typeName;
-				texture.path = str.C_Str();
-				textures.push_back(texture);
-				textures_loaded.push_back(texture);// store it as texture loaded for entire model, to ensure we won't unnecesery load duplicate textures.
-			}
+			const auto it = textureIndex.find(str.C_Str());
+			if (it != textureIndex.end())
+				textures.push_back(textures_loaded[it->second]);
 		}
 		return textures;
 	}
 };
 
 
-unsigned int TextureFromFile(const char* path, const std::string& directory, bool gamma) {
-	std::string filename = std::string(path);
-	filename = directory + '/' + filename;
+DecodedImage DecodeImage(const char* path, const std::string& directory, TextureCache* cache) {
+	DecodedImage image;
+	image.filename = directory + '/' + std::string(path);
+	// a cache hit only maps the compressed levels, the source image is never decoded
+	if (cache && (image.compressed = cache->load(image.filename))) {
+		image.width = image.compressed->levels.front().width;
+		image.height = image.compressed->levels.front().height;
+		return image;
+	}
+
+	image.data.reset(stbi_load(image.filename.c_str(), &image.width, &image.height, &image.components, 0));
+	if (cache && image.data) {
+		auto compressed = compressTexture(image.data.get(), image.width, image.height, image.components);
+		if (!compressed.levels.empty()) {
+			cache->store(image.filename, compressed);
+			image.compressed = std::move(compressed);
+			image.data.reset();
+		}
+	}
+	return image;
+}
 
+unsigned int UploadTexture(const DecodedImage& image) {
 	unsigned int textureID;
 	glGenTextures(1, &textureID);
 
-	int width, height, nrComponents;
-	unsigned char* data = stbi_load(filename.c_str(), &width, &height, &nrComponents, 0);
-	if (data) {
+	if (image.compressed) {
+		const auto& texture = *image.compressed;
+		const GLenum format = texture.format == CompressedTexture::Format::Dxt1 ? GL_COMPRESSED_RGB_S3TC_DXT1_EXT : GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+		glBindTexture(GL_TEXTURE_2D, textureID);
+		for (std::size_t i = 0; i < texture.levels.size(); i++) {
+			const auto& level = texture.levels[i];
+			glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), format, level.width, level.height, 0, static_cast<GLsizei>(level.size), texture.data() + level.offset);
+		}
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(texture.levels.size() - 1));
+	} else if (image.data) {
 		GLenum format;
-		if (nrComponents == 1)
+		if (image.components == 1)
 			format = GL_RED;
-		else if (nrComponents == 3)
+		else if (image.components == 3)
 			format = GL_RGB;
-		else if (nrComponents == 4)
+		else if (image.components == 4)
 			format = GL_RGBA;
 
 		glBindTexture(GL_TEXTURE_2D, textureID);
-		glTexImage2D(GL_TEXTURE_2D, 0, format, width, height, 0, format, GL_UNSIGNED_BYTE, data);
+		glTexImage2D(GL_TEXTURE_2D, 0, format, image.width, image.height, 0, format, GL_UNSIGNED_BYTE, image.data.get());
 		glGenerateMipmap(GL_TEXTURE_2D);
-
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-		stbi_image_free(data);
 	} else {
-		std::cout << "Texture failed to load at path: " << path << std::endl;
-		stbi_image_free(data);
+		std::cout << "Texture failed to load at path: " << image.filename << std::endl;
+		return textureID;
 	}
 
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
 	return textureID;
 }
+
+unsigned int TextureFromFile(const char* path, const std::string& directory, bool gamma) {
+	return UploadTexture(DecodeImage(path, directory));
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_for.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/partitioner.h>
+
+// Parallel loops that can be switched to a fixed task decomposition. In deterministic mode the range is always split
+// the same way, down to chunks of at most `grain` elements, no matter how many threads there are or how work gets
+// stolen, and reductions combine the chunk results in the same order every run. Floating point results are then
+// bit-identical between runs, thread counts and machines.
+//
+// The body is called as body(begin, end) for parallelFor and body(begin, end, accumulator) -> accumulator for
+// parallelReduce.
+
+template <typename Body>
+void parallelFor(std::size_t size, std::size_t grain, bool deterministic, const Body& body) {
+  const tbb::blocked_range<std::size_t> range(0, size, grain);
+  const auto chunk = [&](const tbb::blocked_range<std::size_t>& r) { body(r.begin(), r.end()); };
+  if (deterministic)
+	tbb::parallel_for(range, chunk, tbb::simple_partitioner{});
+  else
+	tbb::parallel_for(range, chunk);
+}
+
+template <typename T, typename Body, typename Combine>
+T parallelReduce(std::size_t size, std::size_t grain, bool deterministic, const T& identity, const Body& body, const Combine& combine) {
+  const tbb::blocked_range<std::size_t> range(0, size, grain);
+  const auto chunk = [&](const tbb::blocked_range<std::size_t>& r, T accumulator) { return body(r.begin(), r.end(), std::move(accumulator)); };
+  if (deterministic)
+	return tbb::parallel_deterministic_reduce(range, identity, chunk, combine, tbb::simple_partitioner{});
+  return tbb::parallel_reduce(range, identity, chunk, combine);
+}
@@ -0,0 +1,52 @@
+#include "point_file.h"
+
+#include <array>
+#include <cstring>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+
+#include "bpa.h"
+
+constexpr std::array<char, 8> pointFileMagic{ 'B', 'P', 'A', 'P', 'T', 'S', '\0', '\0' };
+
+struct PointFileHeader {
+  std::array<char, 8> magic;
+  std::uint32_t pointSize;
+  std::uint32_t reserved;
+  std::uint64_t count;
+};
+
+PointFile::PointFile(const std::filesystem::path& path)
+  : file{ path } {
+  if (!file) {
+	std::cerr << "Could not map point file " << path << '\n';
+	return;
+  }
+
+  PointFileHeader header{};
+  if (file.size() >= sizeof(header))
+	std::memcpy(&header, file.data(), sizeof(header));
+  // the count is compared with what the file holds, multiplying it could wrap for a corrupt header
+  const auto payload = file.size() >= sizeof(header) ? file.size() - sizeof(header) : 0;
+  if (file.size() < sizeof(header) || header.magic != pointFileMagic || header.pointSize != sizeof(Point)
+	  || payload % sizeof(Point) != 0 || header.count != payload / sizeof(Point)) {
+	std::cerr << "Not a point file " << path << '\n';
+	return;
+  }
+
+  // the header keeps the records aligned, mappings start on a page boundary
+  cloud = { reinterpret_cast<const Point*>(file.data() + sizeof(header)), header.count };
+}
+
+bool writePointFile(const std::filesystem::path& path, std::span<const Point> points) {
+  std::ofstream out(path, std::ios::binary | std::ios::trunc);
+  const PointFileHeader header{ pointFileMagic, sizeof(Point), 0, points.size() };
+  out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+  out.write(reinterpret_cast<const char*>(points.data()), static_cast<std::streamsize>(points.size_bytes()));
+  if (!out) {
+	std::cerr << "Could not write point file " << path << '\n';
+	return false;
+  }
+  return true;
+}
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <filesystem>
+#include <span>
+
+#include "bpa.h"
+#include "mapped_file.h"
+
+// Point cloud stored as a small header followed by raw Point records. The file is mapped rather than read, so the
+// reconstruction works on it in place and a cloud larger than RAM only pages in the cells it is working on.
+// Evaluates to false if the file is missing or not a point file.
+class PointFile {
+ public:
+  explicit PointFile(const std::filesystem::path& path);
+
+  std::span<const Point> points() const { return cloud; }
+  explicit operator bool() const { return !cloud.empty(); }
+
+ private:
+  MappedFile file;
+  std::span<const Point> cloud;
+};
+
+bool writePointFile(const std::filesystem::path& path, std::span<const Point> points);
@@ -0,0 +1,146 @@
+#pragma once
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include <glad/glad.h>
+#include <glm/glm.hpp>
+
+#include "bpa.h"
+#include "parallel.h"
+#include "shader.h"
+
+// 16 bytes per point instead of the 24 of Point, the normal is stored as GL_INT_2_10_10_10_REV
+struct SplatVertex {
+  glm::vec3 pos;
+  std::uint32_t normal;
+};
+
+static_assert(sizeof(SplatVertex) == 16);
+
+inline std::uint32_t packNormal(glm::vec3 normal) {
+  const auto component = [](float v) {
+	return static_cast<std::uint32_t>(static_cast<std::int32_t>(std::round(std::clamp(v, -1.0f, 1.0f) * 511.0f))) & 0x3ffu;
+  };
+  return component(normal.x) | component(normal.y) << 10 | component(normal.z) << 20;
+}
+
+// Draws a cloud as lit discs oriented along the point normals (res/shaders/splat.*.glsl). The points live in a
+// persistently mapped buffer that is only reallocated when a cloud does not fit, so reuploading a cloud of the same
+// size, as scans come in, writes straight into GPU visible memory.
+//
+// Every previewStride-th point is stored first, so the preview is a single draw of a prefix of the buffer with the
+// splats enlarged to cover the points left out.
+class PointRenderer {
+ public:
+  PointRenderer() = default;
+
+  ~PointRenderer() {
+	release();
+  }
+
+  PointRenderer(const PointRenderer&) = delete;
+  PointRenderer& operator=(const PointRenderer&) = delete;
+
+  void upload(const std::vector<Point>& points) {
+	if (points.size() > capacity)
+	  allocate(std::max(points.size(), capacity * 2));
+	waitForGpu();
+
+	const auto stride = std::max<std::size_t>(previewStride, 1);
+	previewCount = (points.size() + stride - 1) / stride;
+	count = points.size();
+	parallelFor(points.size(), 1 << 16, false, [&](std::size_t begin, std::size_t end) {
+	  for (auto i = begin; i < end; i++) {
+		const auto skipped = i / stride;
+		const auto target = i % stride == 0 ? skipped : previewCount + i - skipped - 1;
+		mapped[target] = { points[i].pos, packNormal(points[i].normal) };
+	  }
+	});
+  }
+
+  // model, view and projection are set by the caller
+  void render(Shader& shader, float viewportHeight, bool preview) {
+	if (count == 0)
+	  return;
+	const auto stride = std::max<std::size_t>(previewStride, 1);
+	const auto drawn = preview ? previewCount : count;
+
+	glEnable(GL_PROGRAM_POINT_SIZE);
+	shader.use();
+	shader.setFloat("splatRadius", preview ? splatRadius * std::sqrt(static_cast<float>(stride)) : splatRadius);
+	shader.setFloat("viewportHeight", viewportHeight);
+	glBindVertexArray(VAO);
+	glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(drawn));
+	glBindVertexArray(0);
+	glDisable(GL_PROGRAM_POINT_SIZE);
+
+	// the next upload must not overwrite points this draw still reads
+	if (fence)
+	  glDeleteSync(fence);
+	fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+  }
+
+  std::size_t size() const {
+	return count;
+  }
+
+  // world space radius of a splat, about the point spacing
+  float splatRadius = 0.02f;
+  // takes effect on the next upload
+  std::size_t previewStride = 16;
+
+ private:
+  void allocate(std::size_t points) {
+	release();
+	constexpr GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	const auto bytes = static_cast<GLsizeiptr>(points * sizeof(SplatVertex));
+	glGenVertexArrays(1, &VAO);
+	glGenBuffers(1, &VBO);
+	glBindVertexArray(VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	glBufferStorage(GL_ARRAY_BUFFER, bytes, nullptr, flags);
+	mapped = static_cast<SplatVertex*>(glMapBufferRange(GL_ARRAY_BUFFER, 0, bytes, flags));
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(SplatVertex), (void*)offsetof(SplatVertex, pos));
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(SplatVertex), (void*)offsetof(SplatVertex, normal));
+	glEnableVertexAttribArray(1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	capacity = points;
+  }
+
+  void waitForGpu() {
+	if (!fence)
+	  return;
+	while (glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED) {
+	}
+	glDeleteSync(fence);
+	fence = nullptr;
+  }
+
+  void release() {
+	waitForGpu();
+	if (VBO != 0) {
+	  glBindBuffer(GL_ARRAY_BUFFER, VBO);
+	  glUnmapBuffer(GL_ARRAY_BUFFER);
+	  glBindBuffer(GL_ARRAY_BUFFER, 0);
+	  glDeleteBuffers(1, &VBO);
+	  glDeleteVertexArrays(1, &VAO);
+	}
+	VAO = VBO = 0;
+	mapped = nullptr;
+	capacity = count = previewCount = 0;
+  }
+
+  unsigned int VAO = 0;
+  unsigned int VBO = 0;
+  SplatVertex* mapped = nullptr;
+  GLsync fence = nullptr;
+  std::size_t capacity = 0;
+  std::size_t count = 0;
+  std::size_t previewCount = 0;
+};
@@ -0,0 +1,61 @@
+#include "radix_sort.h"
+
+#include <algorithm>
+#include <array>
+
+#include "parallel.h"
+
+constexpr std::size_t radixChunkSize = 1 << 16;
+
+void parallelRadixSort(std::vector<std::uint64_t>& keys, std::vector<std::uint32_t>& values, int keyBits) {
+  const auto n = keys.size();
+  if (n < 2)
+	return;
+
+  const auto chunks = (n + radixChunkSize - 1) / radixChunkSize;
+  std::vector<std::array<std::size_t, 256>> histograms(chunks);
+  std::vector<std::uint64_t> keysOut(n);
+  std::vector<std::uint32_t> valuesOut(n);
+
+  for (auto shift = 0; shift < keyBits; shift += 8) {
+	parallelFor(chunks, 1, false, [&](std::size_t from, std::size_t to) {
+	  for (auto c = from; c < to; c++) {
+		auto& histogram = histograms[c];
+		histogram.fill(0);
+		const auto end = std::min(n, (c + 1) * radixChunkSize);
+		for (auto i = c * radixChunkSize; i < end; i++)
+		  histogram[(keys[i] >> shift) & 0xff]++;
+	  }
+	});
+
+	// turn the counts into exclusive offsets, digit major and chunk minor so equal digits keep their order
+	std::size_t offset = 0;
+	auto digitsUsed = 0;
+	for (auto digit = 0; digit < 256; digit++) {
+	  const auto digitStart = offset;
+	  for (auto& histogram : histograms) {
+		const auto count = histogram[digit];
+		histogram[digit] = offset;
+		offset += count;
+	  }
+	  digitsUsed += offset != digitStart;
+	}
+	// all keys share this digit, the pass would not move anything
+	if (digitsUsed == 1)
+	  continue;
+
+	parallelFor(chunks, 1, false, [&](std::size_t from, std::size_t to) {
+	  for (auto c = from; c < to; c++) {
+		auto& histogram = histograms[c];
+		const auto end = std::min(n, (c + 1) * radixChunkSize);
+		for (auto i = c * radixChunkSize; i < end; i++) {
+		  const auto slot = histogram[(keys[i] >> shift) & 0xff]++;
+		  keysOut[slot] = keys[i];
+		  valuesOut[slot] = values[i];
+		}
+	  }
+	});
+	keys.swap(keysOut);
+	values.swap(valuesOut);
+  }
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+// Stable LSD radix sort of keys together with their values, 8 bits per pass, looking only at the low keyBits bits.
+// Every pass histograms and scatters fixed-size chunks in parallel and lays the chunks out in order, so the result is
+// the same as a serial stable sort for any number of threads.
+void parallelRadixSort(std::vector<std::uint64_t>& keys, std::vector<std::uint32_t>& values, int keyBits = 64);
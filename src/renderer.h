@@ -1,12 +1,21 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <iostream>
+#include <unordered_map>
 
 #include <glad/glad.h>
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
 #include "bpa.h"
+#include "chunked.h"
+#include "decimate.h"
+#include "frustum.h"
 #include "gl_debug.h"
+#include "lights.h"
+#include "lod.h"
 #include "shader.h"
 // #include "structures.h"
 #include "window.h"
@@ -15,6 +24,13 @@
 
 #include "framebuffer.h"
 
+// an instance of renderGizmos, position and scale share a vec4 attribute
+struct Gizmo {
+  glm::vec3 position;
+  float scale;
+  glm::vec3 color;
+};
+
 class Renderer {
  public:
   Renderer(Window& w, Camera& c) : window{ w }, camera{ c } {
@@ -52,319 +68,7 @@ class Renderer {
   }
 
   void renderCube(Shader& shader, glm::vec3 position) {
-	if (cubeVAO == 0) {
-	  float vertices[] = {
-		// back face
-		-1.0f,
-		-1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		-1.0f,
-		0.0f,
-		0.0f,// bottom-left
-		1.0f,
-		1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		-1.0f,
-		1.0f,
-		1.0f,// top-right
-		1.0f,
-		-1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		-1.0f,
-		1.0f,
-		0.0f,// bottom-right
-		1.0f,
-		1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		-1.0f,
-		1.0f,
-		1.0f,// top-right
-		-1.0f,
-		-1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		-1.0f,
-		0.0f,
-		0.0f,// bottom-left
-		-1.0f,
-		1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		-1.0f,
-		0.0f,
-		1.0f,// top-left
-		// front face
-		-1.0f,
-		-1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		0.0f,
-		0.0f,// bottom-left
-		1.0f,
-		-1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		1.0f,
-		0.0f,// bottom-right
-		1.0f,
-		1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		1.0f,
-		1.0f,// top-right
-		1.0f,
-		1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		1.0f,
-		1.0f,// top-right
-		-1.0f,
-		1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		0.0f,
-		1.0f,// top-left
-		-1.0f,
-		-1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		0.0f,
-		0.0f,// bottom-left
-		// left face
-		-1.0f,
-		1.0f,
-		1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		0.0f,// top-right
-		-1.0f,
-		1.0f,
-		-1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		1.0f,// top-left
-		-1.0f,
-		-1.0f,
-		-1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		0.0f,
-		1.0f,// bottom-left
-		-1.0f,
-		-1.0f,
-		-1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		0.0f,
-		1.0f,// bottom-left
-		-1.0f,
-		-1.0f,
-		1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		0.0f,
-		0.0f,// bottom-right
-		-1.0f,
-		1.0f,
-		1.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		0.0f,// top-right
-		// right face
-		1.0f,
-		1.0f,
-		1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		0.0f,// top-left
-		1.0f,
-		-1.0f,
-		-1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		0.0f,
-		1.0f,// bottom-right
-		1.0f,
-		1.0f,
-		-1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		1.0f,// top-right
-		1.0f,
-		-1.0f,
-		-1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		0.0f,
-		1.0f,// bottom-right
-		1.0f,
-		1.0f,
-		1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		1.0f,
-		0.0f,// top-left
-		1.0f,
-		-1.0f,
-		1.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		0.0f,
-		0.0f,// bottom-left
-		// bottom face
-		-1.0f,
-		-1.0f,
-		-1.0f,
-		0.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		1.0f,// top-right
-		1.0f,
-		-1.0f,
-		-1.0f,
-		0.0f,
-		-1.0f,
-		0.0f,
-		1.0f,
-		1.0f,// top-left
-		1.0f,
-		-1.0f,
-		1.0f,
-		0.0f,
-		-1.0f,
-		0.0f,
-		1.0f,
-		0.0f,// bottom-left
-		1.0f,
-		-1.0f,
-		1.0f,
-		0.0f,
-		-1.0f,
-		0.0f,
-		1.0f,
-		0.0f,// bottom-left
-		-1.0f,
-		-1.0f,
-		1.0f,
-		0.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		0.0f,// bottom-right
-		-1.0f,
-		-1.0f,
-		-1.0f,
-		0.0f,
-		-1.0f,
-		0.0f,
-		0.0f,
-		1.0f,// top-right
-		// top face
-		-1.0f,
-		1.0f,
-		-1.0f,
-		0.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		1.0f,// top-left
-		1.0f,
-		1.0f,
-		1.0f,
-		0.0f,
-		1.0f,
-		0.0f,
-		1.0f,
-		0.0f,// bottom-right
-		1.0f,
-		1.0f,
-		-1.0f,
-		0.0f,
-		1.0f,
-		0.0f,
-		1.0f,
-		1.0f,// top-right
-		1.0f,
-		1.0f,
-		1.0f,
-		0.0f,
-		1.0f,
-		0.0f,
-		1.0f,
-		0.0f,// bottom-right
-		-1.0f,
-		1.0f,
-		-1.0f,
-		0.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		1.0f,// top-left
-		-1.0f,
-		1.0f,
-		1.0f,
-		0.0f,
-		1.0f,
-		0.0f,
-		0.0f,
-		0.0f// bottom-left
-	  };
-	  glGenVertexArrays(1, &cubeVAO);
-	  glGenBuffers(1, &cubeVBO);
-	  // fill buffer
-	  glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
-	  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
-	  // link vertex attributes
-	  glBindVertexArray(cubeVAO);
-	  glEnableVertexAttribArray(0);
-	  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
-	  glEnableVertexAttribArray(1);
-	  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
-	  glEnableVertexAttribArray(2);
-	  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
-	  glBindBuffer(GL_ARRAY_BUFFER, 0);
-	  glBindVertexArray(0);
-	}
+	setupCube();
 	shader.use();
 
 	auto modelMat = glm::mat4(1.0f);
@@ -416,6 +120,59 @@ class Renderer {
 	glDeleteVertexArrays(1, &VAO);
   }
 
+  // One instanced draw of a cube per gizmo (light boxes, scan station markers), with res/shaders/gizmo.*.glsl.
+  void renderGizmos(Shader& shader, const std::vector<Gizmo>& gizmos) {
+	if (gizmos.empty())
+	  return;
+	setupCube();
+	if (gizmoVBO == 0) {
+	  glGenBuffers(1, &gizmoVBO);
+	  glBindVertexArray(cubeVAO);
+	  glBindBuffer(GL_ARRAY_BUFFER, gizmoVBO);
+	  glEnableVertexAttribArray(3);
+	  glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(Gizmo), (void*)offsetof(Gizmo, position));
+	  glVertexAttribDivisor(3, 1);
+	  glEnableVertexAttribArray(4);
+	  glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Gizmo), (void*)offsetof(Gizmo, color));
+	  glVertexAttribDivisor(4, 1);
+	  glBindBuffer(GL_ARRAY_BUFFER, 0);
+	  glBindVertexArray(0);
+	}
+	// a handful of instances, the buffer is simply respecified every frame
+	glBindBuffer(GL_ARRAY_BUFFER, gizmoVBO);
+	glBufferData(GL_ARRAY_BUFFER, gizmos.size() * sizeof(Gizmo), gizmos.data(), GL_STREAM_DRAW);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	shader.use();
+	glBindVertexArray(cubeVAO);
+	glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(gizmos.size()));
+	glBindVertexArray(0);
+  }
+
+  // Draws a mesh whose triangles share their vertices with glDrawElements, with smooth vertex normals. The mesh is
+  // uploaded on the first call and kept by its address until releaseMesh.
+  void renderMesh(Shader& shader, const IndexedMesh& mesh) {
+	auto [it, inserted] = indexedGeometry.try_emplace(&mesh);
+	if (inserted)
+	  it->second = uploadIndexed(mesh);
+	shader.use();
+	shader.setMat4("model", meshTransform());
+	glBindVertexArray(it->second.VAO);
+	glDrawElements(GL_TRIANGLES, it->second.vertexCount, GL_UNSIGNED_INT, (void*)0);
+	glBindVertexArray(0);
+  }
+
+  // frees the buffers of a mesh drawn with renderMesh, before it changes or goes away
+  void releaseMesh(const IndexedMesh& mesh) {
+	const auto it = indexedGeometry.find(&mesh);
+	if (it == indexedGeometry.end())
+	  return;
+	glDeleteBuffers(1, &it->second.VBO);
+	glDeleteBuffers(1, &it->second.EBO);
+	glDeleteVertexArrays(1, &it->second.VAO);
+	indexedGeometry.erase(it);
+  }
+
   void renderMesh(Shader& shader, std::vector<Triangle>& mesh) {
 	std::vector<float> vertices;
 
@@ -469,10 +226,7 @@ class Renderer {
 
 	shader.use();
 
-	auto modelMat = glm::mat4(1.0f);
-	modelMat = glm::translate(modelMat, glm::vec3(1.0f));
-	modelMat = glm::scale(modelMat, glm::vec3(1.0f));
-	shader.setMat4("model", modelMat);
+	shader.setMat4("model", meshTransform());
 	glBindVertexArray(VAO);
 	glDrawArrays(GL_TRIANGLES, 0, vertices.size() / 3);
 
@@ -484,6 +238,144 @@ class Renderer {
 	glDeleteVertexArrays(1, &VAO);
   }
 
+  // model matrix of the reconstructed mesh
+  static glm::mat4 meshTransform() {
+	auto modelMat = glm::mat4(1.0f);
+	modelMat = glm::translate(modelMat, glm::vec3(1.0f));
+	modelMat = glm::scale(modelMat, glm::vec3(1.0f));
+	return modelMat;
+  }
+
+  // Draws the selected tiles of a LOD mesh. A tile level is uploaded the first time it is drawn and stays on the GPU
+  // until the resident levels exceed tileMemoryBudget, then the ones not drawn for the longest time are dropped.
+  void renderTiles(Shader& shader, const LodMesh& mesh, const std::vector<TileSelection>& selection) {
+	frame++;
+	shader.use();
+	shader.setMat4("model", meshTransform());
+	for (const auto& s : selection) {
+	  const auto key = static_cast<std::uint64_t>(s.tile) << 32 | s.level;
+	  auto [it, inserted] = residentTiles.try_emplace(key);
+	  auto& tile = it->second;
+	  if (inserted) {
+		tile = uploadTriangles(mesh.tiles()[s.tile].levels[s.level]);
+		residentBytes += tile.bytes;
+	  }
+	  tile.lastFrame = frame;
+	  glBindVertexArray(tile.VAO);
+	  glDrawArrays(GL_TRIANGLES, 0, tile.vertexCount);
+	}
+	glBindVertexArray(0);
+
+	while (residentBytes > tileMemoryBudget) {
+	  auto oldest = residentTiles.end();
+	  for (auto it = residentTiles.begin(); it != residentTiles.end(); it++) {
+		if (it->second.lastFrame != frame && (oldest == residentTiles.end() || it->second.lastFrame < oldest->second.lastFrame))
+		  oldest = it;
+	  }
+	  // everything left is on screen
+	  if (oldest == residentTiles.end())
+		break;
+	  residentBytes -= oldest->second.bytes;
+	  glDeleteBuffers(1, &oldest->second.VBO);
+	  glDeleteVertexArrays(1, &oldest->second.VAO);
+	  residentTiles.erase(oldest);
+	}
+  }
+
+  // frees every resident tile, before the LOD mesh they were cut from is replaced
+  void releaseTiles() {
+	for (auto& [key, tile] : residentTiles) {
+	  glDeleteBuffers(1, &tile.VBO);
+	  glDeleteVertexArrays(1, &tile.VAO);
+	}
+	residentTiles.clear();
+	residentBytes = 0;
+  }
+
+  std::size_t tileMemoryBudget = 512ull << 20;
+
+  // Adds triangles to a mesh that arrives in batches (see AsyncReconstruction). The buffer doubles when it is full, the
+  // triangles already there are copied over on the GPU.
+  void appendStreamed(const std::vector<Triangle>& triangles) {
+	streamedVertices.clear();
+	appendVertices(triangles, streamedVertices);
+	const auto bytes = streamedVertices.size() * sizeof(float);
+	if (streamed.bytes + bytes > streamedCapacity) {
+	  const auto capacity = std::max({ streamedCapacity * 2, streamed.bytes + bytes, std::size_t{ 1 } << 20 });
+	  GpuGeometry grown;
+	  grown.vertexCount = streamed.vertexCount;
+	  grown.bytes = streamed.bytes;
+	  glGenVertexArrays(1, &grown.VAO);
+	  glGenBuffers(1, &grown.VBO);
+	  glBindVertexArray(grown.VAO);
+	  glBindBuffer(GL_ARRAY_BUFFER, grown.VBO);
+	  glBufferData(GL_ARRAY_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+	  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+	  glEnableVertexAttribArray(0);
+	  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+	  glEnableVertexAttribArray(1);
+	  glBindVertexArray(0);
+	  if (streamed.VBO != 0) {
+		glBindBuffer(GL_COPY_READ_BUFFER, streamed.VBO);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_ARRAY_BUFFER, 0, 0, streamed.bytes);
+		glBindBuffer(GL_COPY_READ_BUFFER, 0);
+		glDeleteBuffers(1, &streamed.VBO);
+		glDeleteVertexArrays(1, &streamed.VAO);
+	  }
+	  streamed = grown;
+	  streamedCapacity = capacity;
+	}
+	glBindBuffer(GL_ARRAY_BUFFER, streamed.VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, streamed.bytes, bytes, streamedVertices.data());
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	streamed.bytes += bytes;
+	streamed.vertexCount += static_cast<GLsizei>(triangles.size() * 3);
+  }
+
+  // empties the streamed mesh and keeps its buffer for the next one
+  void clearStreamed() {
+	streamed.bytes = 0;
+	streamed.vertexCount = 0;
+  }
+
+  void renderStreamed(Shader& shader) {
+	if (streamed.vertexCount == 0)
+	  return;
+	shader.use();
+	shader.setMat4("model", meshTransform());
+	glBindVertexArray(streamed.VAO);
+	glDrawArrays(GL_TRIANGLES, 0, streamed.vertexCount);
+	glBindVertexArray(0);
+  }
+
+  // Draws the chunks of the cloud inside the frustum, which is in the space of meshTransform. The points are uploaded on
+  // the first call and drawn from there with one multi-draw of the visible ranges.
+  void renderPoints(Shader& shader, const Chunked<Point>& points, const Frustum& frustum) {
+	auto [it, inserted] = chunkedGeometry.try_emplace(points.id());
+	if (inserted)
+	  it->second = uploadPoints(points.items());
+	points.visibleRanges(frustum, drawFirst, drawCount);
+	drawRanges(shader, it->second, GL_POINTS, 1);
+  }
+
+  void renderMesh(Shader& shader, const Chunked<Triangle>& mesh, const Frustum& frustum) {
+	auto [it, inserted] = chunkedGeometry.try_emplace(mesh.id());
+	if (inserted)
+	  it->second = uploadTriangles(mesh.items());
+	mesh.visibleRanges(frustum, drawFirst, drawCount);
+	drawRanges(shader, it->second, GL_TRIANGLES, 3);
+  }
+
+  // frees the buffer of a chunked cloud or mesh, by its id, before it goes away
+  void releaseChunks(std::uint64_t id) {
+	const auto it = chunkedGeometry.find(id);
+	if (it == chunkedGeometry.end())
+	  return;
+	glDeleteBuffers(1, &it->second.VBO);
+	glDeleteVertexArrays(1, &it->second.VAO);
+	chunkedGeometry.erase(it);
+  }
+
   /*
   void renderPoints(Shader& shader, std::vector<Vector3D*>& points) {
 	std::vector<double> vertices;
@@ -596,6 +488,107 @@ class Renderer {
   }
   */
 
+  // Deferred shading. The geometry pass writes position, normal and albedo/specular of the surfaces to the G-buffer of
+  // framebuffer.h; draw them with a shader writing those three outputs (res/shaders/gbuffer.fs.glsl) between
+  // beginGeometryPass and lightingPass.
+  void beginGeometryPass() {
+	if (gBuffer == 0) {
+	  createGBuffer(gBuffer, gPosition, gNormal, gAlbedoSpec);
+	  createRenderBuffer(rboDepth);
+	  if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE)
+		std::cerr << "G-buffer incomplete\n";
+	}
+	glBindFramebuffer(GL_FRAMEBUFFER, gBuffer);
+	glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
+	glClearColor(0.0f, 0.0f, 0.0f, 0.0f);
+	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+  }
+
+  // Lights the G-buffer into the target framebuffer, whose color is kept where there is no surface. The directional
+  // light is one full screen pass, every point light only shades the pixels of the back faces of its light volume that
+  // lie behind a surface, so the cost follows the lit pixels instead of fragments times lights. The depth of the
+  // G-buffer (depth 24, stencil 8, as requested for the window) is copied to the target for the forward passes drawn
+  // afterwards.
+  void lightingPass(Shader& directional, Shader& volumes, const std::vector<LightVolume>& lights, const glm::mat4& projection, const glm::mat4& view, glm::vec3 viewPos, unsigned int target) {
+	// the window may have been resized, offscreen targets have the size of the G-buffer
+	const auto targetWidth = target == 0 ? static_cast<GLint>(width()) : static_cast<GLint>(SCREEN_WIDTH);
+	const auto targetHeight = target == 0 ? static_cast<GLint>(height()) : static_cast<GLint>(SCREEN_HEIGHT);
+	glBindFramebuffer(GL_READ_FRAMEBUFFER, gBuffer);
+	glBindFramebuffer(GL_DRAW_FRAMEBUFFER, target);
+	glBlitFramebuffer(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT, 0, 0, targetWidth, targetHeight, GL_DEPTH_BUFFER_BIT, GL_NEAREST);
+	glBindFramebuffer(GL_FRAMEBUFFER, target);
+	glViewport(0, 0, targetWidth, targetHeight);
+
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D, gPosition);
+	glActiveTexture(GL_TEXTURE1);
+	glBindTexture(GL_TEXTURE_2D, gNormal);
+	glActiveTexture(GL_TEXTURE2);
+	glBindTexture(GL_TEXTURE_2D, gAlbedoSpec);
+	for (auto* shader : { &directional, &volumes }) {
+	  shader->use();
+	  shader->setInt("gPosition", 0);
+	  shader->setInt("gNormal", 1);
+	  shader->setInt("gAlbedoSpec", 2);
+	  shader->setVec3("viewPos", viewPos);
+	}
+
+	glDepthMask(GL_FALSE);
+	glDisable(GL_DEPTH_TEST);
+	directional.use();
+	renderQuad();
+
+	if (!lights.empty()) {
+	  setupCube();
+	  if (lightVolumeVAO == 0) {
+		glGenVertexArrays(1, &lightVolumeVAO);
+		glGenBuffers(1, &lightVolumeVBO);
+		glBindVertexArray(lightVolumeVAO);
+		glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+		glBindBuffer(GL_ARRAY_BUFFER, lightVolumeVBO);
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(3, 4, GL_FLOAT, GL_FALSE, sizeof(LightVolume), (void*)offsetof(LightVolume, position));
+		glVertexAttribDivisor(3, 1);
+		glEnableVertexAttribArray(4);
+		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(LightVolume), (void*)offsetof(LightVolume, color));
+		glVertexAttribDivisor(4, 1);
+		glEnableVertexAttribArray(5);
+		glVertexAttribPointer(5, 2, GL_FLOAT, GL_FALSE, sizeof(LightVolume), (void*)offsetof(LightVolume, linear));
+		glVertexAttribDivisor(5, 1);
+		glBindVertexArray(0);
+	  }
+	  glBindBuffer(GL_ARRAY_BUFFER, lightVolumeVBO);
+	  glBufferData(GL_ARRAY_BUFFER, lights.size() * sizeof(LightVolume), lights.data(), GL_STREAM_DRAW);
+	  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+	  // back faces, which stay in front of the camera when it is inside a volume, and only where they are behind the
+	  // surface seen through them
+	  glEnable(GL_DEPTH_TEST);
+	  glDepthFunc(GL_GEQUAL);
+	  glEnable(GL_CULL_FACE);
+	  glCullFace(GL_FRONT);
+	  glEnable(GL_BLEND);
+	  glBlendFunc(GL_ONE, GL_ONE);
+	  volumes.use();
+	  volumes.setMat4("projection", projection);
+	  volumes.setMat4("view", view);
+	  volumes.setVec2("screenSize", static_cast<float>(targetWidth), static_cast<float>(targetHeight));
+	  glBindVertexArray(lightVolumeVAO);
+	  glDrawArraysInstanced(GL_TRIANGLES, 0, 36, static_cast<GLsizei>(lights.size()));
+	  glBindVertexArray(0);
+	  glDisable(GL_BLEND);
+	  glCullFace(GL_BACK);
+	  glDisable(GL_CULL_FACE);
+	  glDepthFunc(GL_LESS);
+	}
+
+	glEnable(GL_DEPTH_TEST);
+	glDepthMask(GL_TRUE);
+	glActiveTexture(GL_TEXTURE0);
+  }
+
   void renderQuad() {
 	if (quadVAO == 0) {
 	  float quadVertices[] = {
@@ -643,13 +636,461 @@ class Renderer {
  private:
   Window& window;
   Camera& camera;
-  unsigned int gBuffer;
-  unsigned int gPosition, gNormal, gAlbedoSpec;
-  unsigned int rboDepth;
+  unsigned int gBuffer = 0;
+  unsigned int gPosition = 0, gNormal = 0, gAlbedoSpec = 0;
+  unsigned int rboDepth = 0;
   std::vector<glm::vec3> lightPositions;
   std::vector<glm::vec3> lightColors;
   unsigned int cubeVAO = 0;
   unsigned int cubeVBO = 0;
   unsigned int quadVAO = 0;
   unsigned int quadVBO = 0;
+
+  unsigned int gizmoVBO = 0;
+  unsigned int lightVolumeVAO = 0;
+  unsigned int lightVolumeVBO = 0;
+
+  void setupCube() {
+	if (cubeVAO == 0) {
+	  float vertices[] = {
+		// back face
+		-1.0f,
+		-1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		-1.0f,
+		0.0f,
+		0.0f,// bottom-left
+		1.0f,
+		1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		-1.0f,
+		1.0f,
+		1.0f,// top-right
+		1.0f,
+		-1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		-1.0f,
+		1.0f,
+		0.0f,// bottom-right
+		1.0f,
+		1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		-1.0f,
+		1.0f,
+		1.0f,// top-right
+		-1.0f,
+		-1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		-1.0f,
+		0.0f,
+		0.0f,// bottom-left
+		-1.0f,
+		1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		-1.0f,
+		0.0f,
+		1.0f,// top-left
+		// front face
+		-1.0f,
+		-1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		0.0f,
+		0.0f,// bottom-left
+		1.0f,
+		-1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		1.0f,
+		0.0f,// bottom-right
+		1.0f,
+		1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		1.0f,
+		1.0f,// top-right
+		1.0f,
+		1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		1.0f,
+		1.0f,// top-right
+		-1.0f,
+		1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		0.0f,
+		1.0f,// top-left
+		-1.0f,
+		-1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		0.0f,
+		0.0f,// bottom-left
+		// left face
+		-1.0f,
+		1.0f,
+		1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		0.0f,// top-right
+		-1.0f,
+		1.0f,
+		-1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		1.0f,// top-left
+		-1.0f,
+		-1.0f,
+		-1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		0.0f,
+		1.0f,// bottom-left
+		-1.0f,
+		-1.0f,
+		-1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		0.0f,
+		1.0f,// bottom-left
+		-1.0f,
+		-1.0f,
+		1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		0.0f,
+		0.0f,// bottom-right
+		-1.0f,
+		1.0f,
+		1.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		0.0f,// top-right
+		// right face
+		1.0f,
+		1.0f,
+		1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		0.0f,// top-left
+		1.0f,
+		-1.0f,
+		-1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		0.0f,
+		1.0f,// bottom-right
+		1.0f,
+		1.0f,
+		-1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		1.0f,// top-right
+		1.0f,
+		-1.0f,
+		-1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		0.0f,
+		1.0f,// bottom-right
+		1.0f,
+		1.0f,
+		1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		1.0f,
+		0.0f,// top-left
+		1.0f,
+		-1.0f,
+		1.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		0.0f,
+		0.0f,// bottom-left
+		// bottom face
+		-1.0f,
+		-1.0f,
+		-1.0f,
+		0.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		1.0f,// top-right
+		1.0f,
+		-1.0f,
+		-1.0f,
+		0.0f,
+		-1.0f,
+		0.0f,
+		1.0f,
+		1.0f,// top-left
+		1.0f,
+		-1.0f,
+		1.0f,
+		0.0f,
+		-1.0f,
+		0.0f,
+		1.0f,
+		0.0f,// bottom-left
+		1.0f,
+		-1.0f,
+		1.0f,
+		0.0f,
+		-1.0f,
+		0.0f,
+		1.0f,
+		0.0f,// bottom-left
+		-1.0f,
+		-1.0f,
+		1.0f,
+		0.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		0.0f,// bottom-right
+		-1.0f,
+		-1.0f,
+		-1.0f,
+		0.0f,
+		-1.0f,
+		0.0f,
+		0.0f,
+		1.0f,// top-right
+		// top face
+		-1.0f,
+		1.0f,
+		-1.0f,
+		0.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		1.0f,// top-left
+		1.0f,
+		1.0f,
+		1.0f,
+		0.0f,
+		1.0f,
+		0.0f,
+		1.0f,
+		0.0f,// bottom-right
+		1.0f,
+		1.0f,
+		-1.0f,
+		0.0f,
+		1.0f,
+		0.0f,
+		1.0f,
+		1.0f,// top-right
+		1.0f,
+		1.0f,
+		1.0f,
+		0.0f,
+		1.0f,
+		0.0f,
+		1.0f,
+		0.0f,// bottom-right
+		-1.0f,
+		1.0f,
+		-1.0f,
+		0.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		1.0f,// top-left
+		-1.0f,
+		1.0f,
+		1.0f,
+		0.0f,
+		1.0f,
+		0.0f,
+		0.0f,
+		0.0f// bottom-left
+	  };
+	  glGenVertexArrays(1, &cubeVAO);
+	  glGenBuffers(1, &cubeVBO);
+	  // fill buffer
+	  glBindBuffer(GL_ARRAY_BUFFER, cubeVBO);
+	  glBufferData(GL_ARRAY_BUFFER, sizeof(vertices), vertices, GL_STATIC_DRAW);
+	  // link vertex attributes
+	  glBindVertexArray(cubeVAO);
+	  glEnableVertexAttribArray(0);
+	  glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)0);
+	  glEnableVertexAttribArray(1);
+	  glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(3 * sizeof(float)));
+	  glEnableVertexAttribArray(2);
+	  glVertexAttribPointer(2, 2, GL_FLOAT, GL_FALSE, 8 * sizeof(float), (void*)(6 * sizeof(float)));
+	  glBindBuffer(GL_ARRAY_BUFFER, 0);
+	  glBindVertexArray(0);
+	}
+  }
+
+  struct GpuGeometry {
+	unsigned int VAO = 0;
+	unsigned int VBO = 0;
+	// only for indexed geometry, vertexCount is then the number of indices
+	unsigned int EBO = 0;
+	GLsizei vertexCount = 0;
+	std::size_t bytes = 0;
+	std::uint64_t lastFrame = 0;
+  };
+
+  // flat shaded triangles with the same layout as renderMesh, position and face normal per vertex
+  static void appendVertices(const std::vector<Triangle>& triangles, std::vector<float>& vertices) {
+	vertices.reserve(vertices.size() + triangles.size() * 18);
+	for (const auto& triangle : triangles) {
+	  const auto normal = triangle.normal();
+	  for (const auto& v : triangle)
+		vertices.insert(vertices.end(), { v.x, v.y, v.z, normal.x, normal.y, normal.z });
+	}
+  }
+
+  GpuGeometry uploadTriangles(const std::vector<Triangle>& triangles) {
+	std::vector<float> vertices;
+	appendVertices(triangles, vertices);
+
+	GpuGeometry gpu;
+	gpu.vertexCount = static_cast<GLsizei>(triangles.size() * 3);
+	gpu.bytes = vertices.size() * sizeof(float);
+	glGenVertexArrays(1, &gpu.VAO);
+	glGenBuffers(1, &gpu.VBO);
+	glBindVertexArray(gpu.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, gpu.VBO);
+	glBufferData(GL_ARRAY_BUFFER, gpu.bytes, vertices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	return gpu;
+  }
+
+  // position and area weighted vertex normal per shared vertex, 24 bytes per vertex and 12 per triangle instead of the
+  // 72 per triangle of uploadTriangles
+  GpuGeometry uploadIndexed(const IndexedMesh& mesh) {
+	std::vector<glm::vec3> normals(mesh.positions.size(), glm::vec3{ 0.0f });
+	for (const auto& t : mesh.triangles) {
+	  // the cross product is twice the area, larger triangles weigh more
+	  const auto n = glm::cross(mesh.positions[t[1]] - mesh.positions[t[0]], mesh.positions[t[2]] - mesh.positions[t[0]]);
+	  for (const auto v : t)
+		normals[v] += n;
+	}
+	std::vector<float> vertices;
+	vertices.reserve(mesh.positions.size() * 6);
+	for (std::size_t i = 0; i < mesh.positions.size(); i++) {
+	  const auto& p = mesh.positions[i];
+	  const auto length = glm::length(normals[i]);
+	  const auto normal = length > 0.0f ? normals[i] / length : glm::vec3{ 0.0f };
+	  vertices.insert(vertices.end(), { p.x, p.y, p.z, normal.x, normal.y, normal.z });
+	}
+
+	GpuGeometry gpu;
+	gpu.vertexCount = static_cast<GLsizei>(mesh.triangles.size() * 3);
+	gpu.bytes = vertices.size() * sizeof(float) + mesh.triangles.size() * sizeof(IndexedTriangle);
+	glGenVertexArrays(1, &gpu.VAO);
+	glGenBuffers(1, &gpu.VBO);
+	glGenBuffers(1, &gpu.EBO);
+	glBindVertexArray(gpu.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, gpu.VBO);
+	glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(float), vertices.data(), GL_STATIC_DRAW);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, gpu.EBO);
+	glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.triangles.size() * sizeof(IndexedTriangle), mesh.triangles.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, 6 * sizeof(float), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+	return gpu;
+  }
+
+  GpuGeometry uploadPoints(const std::vector<Point>& points) {
+	std::vector<float> vertices;
+	vertices.reserve(points.size() * 3);
+	for (const auto& point : points)
+	  vertices.insert(vertices.end(), { point.pos.x, point.pos.y, point.pos.z });
+
+	GpuGeometry gpu;
+	gpu.vertexCount = static_cast<GLsizei>(points.size());
+	gpu.bytes = vertices.size() * sizeof(float);
+	glGenVertexArrays(1, &gpu.VAO);
+	glGenBuffers(1, &gpu.VBO);
+	glBindVertexArray(gpu.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, gpu.VBO);
+	glBufferData(GL_ARRAY_BUFFER, gpu.bytes, vertices.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 3 * sizeof(float), (void*)0);
+	glEnableVertexAttribArray(0);
+	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	glBindVertexArray(0);
+	return gpu;
+  }
+
+  // the ranges in drawFirst and drawCount are in items of the given number of vertices
+  void drawRanges(Shader& shader, const GpuGeometry& gpu, GLenum mode, GLint verticesPerItem) {
+	for (std::size_t i = 0; i < drawFirst.size(); i++) {
+	  drawFirst[i] *= verticesPerItem;
+	  drawCount[i] *= verticesPerItem;
+	}
+	shader.use();
+	shader.setMat4("model", meshTransform());
+	glBindVertexArray(gpu.VAO);
+	glMultiDrawArrays(mode, drawFirst.data(), drawCount.data(), static_cast<GLsizei>(drawFirst.size()));
+	glBindVertexArray(0);
+  }
+
+  std::uint64_t frame = 0;
+  std::unordered_map<std::uint64_t, GpuGeometry> residentTiles;
+  std::size_t residentBytes = 0;
+  // buffers of the chunked clouds and meshes by Chunked::id
+  std::unordered_map<std::uint64_t, GpuGeometry> chunkedGeometry;
+  std::unordered_map<const IndexedMesh*, GpuGeometry> indexedGeometry;
+  // bytes is the part of the buffer in use
+  GpuGeometry streamed;
+  std::size_t streamedCapacity = 0;
+  std::vector<float> streamedVertices;
+  std::vector<std::int32_t> drawFirst;
+  std::vector<std::int32_t> drawCount;
 };
@@ -4,9 +4,12 @@
 #include <glm/glm.hpp>
 
 #include <string>
+#include <string_view>
 #include <fstream>
 #include <sstream>
 #include <iostream>
+#include <unordered_map>
+#include <vector>
 
 class Shader {
   public:
@@ -81,6 +84,7 @@ class Shader {
 			glAttachShader(ID, geometry);
 		glLinkProgram(ID);
 		checkCompileErrors(ID, "PROGRAM");
+		cacheUniformLocations();
 		// delete the shaders as they're linked into our program now and no longer necessery
 		glDeleteShader(vertex);
 		glDeleteShader(fragment);
@@ -92,54 +96,105 @@ class Shader {
 	void use() {
 		glUseProgram(ID);
 	}
+	// location of a uniform, looked up once at link time; -1, which glUniform ignores, for names the linker dropped
+	// ------------------------------------------------------------------------
+	GLint location(std::string_view name) const {
+		const auto it = uniformLocations.find(name);
+		return it == uniformLocations.end() ? -1 : it->second;
+	}
+	// connects a uniform block of the program to a uniform buffer binding point
+	// ------------------------------------------------------------------------
+	void bindBlock(const char* name, GLuint binding) const {
+		const auto index = glGetUniformBlockIndex(ID, name);
+		if (index != GL_INVALID_INDEX)
+			glUniformBlockBinding(ID, index, binding);
+	}
 	// utility uniform functions
 	// ------------------------------------------------------------------------
-	void setBool(const std::string& name, bool value) const {
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), (int)value);
+	void setBool(std::string_view name, bool value) const {
+		glUniform1i(location(name), (int)value);
 	}
 	// ------------------------------------------------------------------------
-	void setInt(const std::string& name, int value) const {
-		glUniform1i(glGetUniformLocation(ID, name.c_str()), value);
+	void setInt(std::string_view name, int value) const {
+		glUniform1i(location(name), value);
 	}
 	// ------------------------------------------------------------------------
-	void setFloat(const std::string& name, float value) const {
-		glUniform1f(glGetUniformLocation(ID, name.c_str()), value);
+	void setFloat(std::string_view name, float value) const {
+		glUniform1f(location(name), value);
 	}
 	// ------------------------------------------------------------------------
-	void setVec2(const std::string& name, const glm::vec2& value) const {
-		glUniform2fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	void setVec2(std::string_view name, const glm::vec2& value) const {
+		glUniform2fv(location(name), 1, &value[0]);
 	}
-	void setVec2(const std::string& name, float x, float y) const {
-		glUniform2f(glGetUniformLocation(ID, name.c_str()), x, y);
+	void setVec2(std::string_view name, float x, float y) const {
+		glUniform2f(location(name), x, y);
 	}
 	// ------------------------------------------------------------------------
-	void setVec3(const std::string& name, const glm::vec3& value) const {
-		glUniform3fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	void setVec3(std::string_view name, const glm::vec3& value) const {
+		glUniform3fv(location(name), 1, &value[0]);
 	}
-	void setVec3(const std::string& name, float x, float y, float z) const {
-		glUniform3f(glGetUniformLocation(ID, name.c_str()), x, y, z);
+	void setVec3(std::string_view name, float x, float y, float z) const {
+		glUniform3f(location(name), x, y, z);
 	}
 	// ------------------------------------------------------------------------
-	void setVec4(const std::string& name, const glm::vec4& value) const {
-		glUniform4fv(glGetUniformLocation(ID, name.c_str()), 1, &value[0]);
+	void setVec4(std::string_view name, const glm::vec4& value) const {
+		glUniform4fv(location(name), 1, &value[0]);
 	}
-	void setVec4(const std::string& name, float x, float y, float z, float w) {
-		glUniform4f(glGetUniformLocation(ID, name.c_str()), x, y, z, w);
+	void setVec4(std::string_view name, float x, float y, float z, float w) {
+		glUniform4f(location(name), x, y, z, w);
 	}
 	// ------------------------------------------------------------------------
-	void setMat2(const std::string& name, const glm::mat2& mat) const {
-		glUniformMatrix2fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	void setMat2(std::string_view name, const glm::mat2& mat) const {
+		glUniformMatrix2fv(location(name), 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
-	void setMat3(const std::string& name, const glm::mat3& mat) const {
-		glUniformMatrix3fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	void setMat3(std::string_view name, const glm::mat3& mat) const {
+		glUniformMatrix3fv(location(name), 1, GL_FALSE, &mat[0][0]);
 	}
 	// ------------------------------------------------------------------------
-	void setMat4(const std::string& name, const glm::mat4& mat) const {
-		glUniformMatrix4fv(glGetUniformLocation(ID, name.c_str()), 1, GL_FALSE, &mat[0][0]);
+	void setMat4(std::string_view name, const glm::mat4& mat) const {
+		glUniformMatrix4fv(location(name), 1, GL_FALSE, &mat[0][0]);
 	}
 
   private:
+	struct NameHash {
+		using is_transparent = void;
+		std::size_t operator()(std::string_view name) const {
+			return std::hash<std::string_view>{}(name);
+		}
+	};
+	// heterogeneous lookup, the setters find their string literals without building a std::string
+	std::unordered_map<std::string, GLint, NameHash, std::equal_to<>> uniformLocations;
+
+	// every active uniform outside a block, and every element of arrays, which are reported once as "name[0]"
+	// ------------------------------------------------------------------------
+	void cacheUniformLocations() {
+		GLint count = 0;
+		GLint maxLength = 0;
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(ID, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+		std::vector<GLchar> buffer(static_cast<std::size_t>(maxLength) + 1);
+		for (GLint i = 0; i < count; i++) {
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type = 0;
+			glGetActiveUniform(ID, static_cast<GLuint>(i), maxLength, &length, &size, &type, buffer.data());
+			const std::string name(buffer.data(), static_cast<std::size_t>(length));
+			const auto uniform = glGetUniformLocation(ID, name.c_str());
+			if (uniform < 0)
+				continue;
+			uniformLocations[name] = uniform;
+			if (name.ends_with("[0]")) {
+				const auto base = name.substr(0, name.size() - 3);
+				uniformLocations[base] = uniform;
+				for (GLint element = 1; element < size; element++) {
+					const auto elementName = base + "[" + std::to_string(element) + "]";
+					uniformLocations[elementName] = glGetUniformLocation(ID, elementName.c_str());
+				}
+			}
+		}
+	}
+
 	// utility function for checking shader compilation/linking errors.
 	// ------------------------------------------------------------------------
 	void checkCompileErrors(GLuint shader, std::string type) {
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+#include <initializer_list>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+// Points are referred to by their index in the caller's array.
+using PointId = std::uint32_t;
+
+// A point as returned by a neighborhood query, decoded so the pivot loops work on one contiguous buffer.
+struct Neighbor {
+  glm::vec3 pos;
+  glm::vec3 normal;
+  PointId id;
+};
+
+// The distance test of every radius query. All indexes share it, so they agree on points right at the radius.
+inline bool withinRadius(glm::vec3 pos, glm::vec3 center, float radius) {
+  const auto d = pos - center;
+  return glm::dot(d, d) < radius * radius;
+}
+
+// Radius queries over the reconstruction's points. Implementations return the points as the reconstruction sees them,
+// which matters for the quantized mode where positions are snapped.
+class SpatialIndex {
+ public:
+  virtual ~SpatialIndex() = default;
+
+  // Fills result, a scratch buffer of the caller, with the points closer than radius to center. Points at one of the
+  // ignored positions are left out.
+  virtual void radiusQuery(glm::vec3 center, float radius, std::initializer_list<glm::vec3> ignore, std::vector<Neighbor>& result) const = 0;
+};
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <new>
+#include <vector>
+
+// Bounded single producer, single consumer ring buffer. push is only called from one thread and pop from one other,
+// neither blocks or takes a lock: each side owns its index and publishes it with a release store.
+template <typename T>
+class SpscQueue {
+ public:
+  // one slot stays empty to tell a full ring from an empty one
+  explicit SpscQueue(std::size_t capacity) : slots(std::bit_ceil(capacity + 1)), mask(slots.size() - 1) {}
+
+  // false if the queue is full, value is left untouched then
+  bool push(T&& value) {
+	const auto t = tail.load(std::memory_order_relaxed);
+	const auto next = (t + 1) & mask;
+	if (next == head.load(std::memory_order_acquire))
+	  return false;
+	slots[t] = std::move(value);
+	tail.store(next, std::memory_order_release);
+	return true;
+  }
+
+  bool pop(T& value) {
+	const auto h = head.load(std::memory_order_relaxed);
+	if (h == tail.load(std::memory_order_acquire))
+	  return false;
+	value = std::move(slots[h]);
+	head.store((h + 1) & mask, std::memory_order_release);
+	return true;
+  }
+
+ private:
+  std::vector<T> slots;
+  std::size_t mask;
+  // on separate cache lines so the two threads do not invalidate each other's index
+  alignas(64) std::atomic<std::size_t> head{ 0 };
+  alignas(64) std::atomic<std::size_t> tail{ 0 };
+};
@@ -2,8 +2,8 @@
 
 #include "structures.h"
 
-Vector3D::Vector3D(double x, double y, double z, uint8_t r, uint8_t g, uint8_t b) {
-  Id = GenerateRunningId();
+Vector3D::Vector3D(int id, double x, double y, double z, uint8_t r, uint8_t g, uint8_t b) {
+  Id = id;
 
   X = x;
   Y = y;
@@ -14,8 +14,8 @@ Vector3D::Vector3D(double x, double y, double z, uint8_t r, uint8_t g, uint8_t b
   B = b;
 }
 
-Vector3D::Vector3D(double x, double y, double z, bool isAuxiliaryDot, uint8_t r, uint8_t g, uint8_t b) {
-  Id = GenerateRunningId();
+Vector3D::Vector3D(int id, double x, double y, double z, bool isAuxiliaryDot, uint8_t r, uint8_t g, uint8_t b) {
+  Id = id;
 
   IsAuxiliaryDot = isAuxiliaryDot;
 
@@ -48,11 +48,6 @@ Vector3D::Vector3D(Vector3D* dot, double lengthAfterProjection) {
 Vector3D::~Vector3D() {
 }
 
-int Vector3D::GenerateRunningId() {
-  static int id = 0;
-  return id++;
-}
-
 bool Vector3D::IsCoincidentWith(Vector3D* dot) {
   return (X == dot->X && Y == dot->Y && Z == dot->Z);
 }
@@ -66,8 +61,8 @@ std::string Vector3D::ToString() {
 }
 
 
-Triangle::Triangle(Vector3D* v0, Vector3D* v1, Vector3D* v2) {
-  Id = GenerateRunningId();
+Triangle::Triangle(int id, Vector3D* v0, Vector3D* v1, Vector3D* v2) {
+  Id = id;
   Vertex[0] = v0;
   Vertex[1] = v1;
   Vertex[2] = v2;
@@ -76,11 +71,6 @@ Triangle::Triangle(Vector3D* v0, Vector3D* v1, Vector3D* v2) {
 Triangle::~Triangle() {
 }
 
-int Triangle::GenerateRunningId() {
-  static int id = 0;
-  return id++;
-}
-
 bool Triangle::HasVertexCoincidentWith(Vector3D* dot) {
   return Vertex[0]->IsCoincidentWith(dot)
 		 || Vertex[1]->IsCoincidentWith(dot)
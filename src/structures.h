@@ -6,10 +6,8 @@
 
 
 class Vector3D {
- private:
-  int GenerateRunningId();
-
  public:
+  // assigned by whoever creates the dot, there is no global counter so triangulations can run concurrently
   int Id = 0;
 
   // coordinate
@@ -21,8 +19,8 @@ class Vector3D {
   bool IsVisited = false;
   bool IsAuxiliaryDot = false;
 
-  Vector3D(double x, double y, double z, uint8_t r = 255, uint8_t g = 248, uint8_t b = 220);
-  Vector3D(double x, double y, double z, bool isAuxiliaryDot, uint8_t r = 255, uint8_t g = 248, uint8_t b = 220);
+  Vector3D(int id, double x, double y, double z, uint8_t r = 255, uint8_t g = 248, uint8_t b = 220);
+  Vector3D(int id, double x, double y, double z, bool isAuxiliaryDot, uint8_t r = 255, uint8_t g = 248, uint8_t b = 220);
   Vector3D(Vector3D* dot, double lengthAfterProjection);
   ~Vector3D();
 
@@ -31,10 +29,8 @@ class Vector3D {
 };
 
 class Triangle {
- private:
-  int GenerateRunningId();
-
  public:
+  // assigned by the owning DelaunayTriangulation
   int Id = 0;
 
   // pointers pointing to 3 vertices
@@ -43,7 +39,7 @@ class Triangle {
   // pointers pointing to 3 neighbors
   Triangle* Neighbor[3];
 
-  Triangle(Vector3D* v0, Vector3D* v1, Vector3D* v2);
+  Triangle(int id, Vector3D* v0, Vector3D* v1, Vector3D* v2);
   ~Triangle();
 
   bool HasVertexCoincidentWith(Vector3D* dot);
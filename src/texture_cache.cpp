@@ -0,0 +1,182 @@
+#include "texture_cache.h"
+
+#include <algorithm>
+#include <array>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <system_error>
+
+#include <SOIL/image_helper.h>
+extern "C" {
+#include <SOIL/image_dxt.h>
+}
+
+#include "cache_directory.h"
+#include "hash.h"
+
+namespace fs = std::filesystem;
+
+// bump whenever the file layout or the compression changes, so stale entries are never read back
+constexpr std::uint32_t cacheVersion = 1;
+constexpr std::array<char, 8> cacheMagic{ 'B', 'P', 'A', 'T', 'E', 'X', '\0', '\0' };
+
+struct CacheHeader {
+  std::array<char, 8> magic;
+  std::uint32_t version;
+  CompressedTexture::Format format;
+  std::uint64_t key;
+  std::uint64_t levels;
+};
+
+struct CacheLevel {
+  std::int32_t width;
+  std::int32_t height;
+  std::uint64_t size;
+};
+
+CompressedTexture compressTexture(const unsigned char* pixels, int width, int height, int channels) {
+  CompressedTexture texture;
+  texture.format = channels % 2 == 1 ? CompressedTexture::Format::Dxt1 : CompressedTexture::Format::Dxt5;
+
+  std::vector<unsigned char> current;
+  std::vector<unsigned char> next;
+  const unsigned char* level = pixels;
+  while (true) {
+	int size = 0;
+	auto* compressed = texture.format == CompressedTexture::Format::Dxt1
+	  ? convert_image_to_DXT1(level, width, height, channels, &size)
+	  : convert_image_to_DXT5(level, width, height, channels, &size);
+	const std::unique_ptr<unsigned char, decltype(&std::free)> blocks{ compressed, &std::free };
+	if (!blocks)
+	  return {};
+
+	const auto offset = texture.storage.size();
+	texture.storage.resize(offset + static_cast<std::size_t>(size));
+	std::memcpy(texture.storage.data() + offset, blocks.get(), static_cast<std::size_t>(size));
+	texture.levels.push_back({ width, height, offset, static_cast<std::size_t>(size) });
+
+	if (width == 1 && height == 1)
+	  break;
+
+	// box filter down to the next level, a dimension that already reached 1 stays 1
+	const auto blockX = width > 1 ? 2 : 1;
+	const auto blockY = height > 1 ? 2 : 1;
+	next.resize(static_cast<std::size_t>(width / blockX) * static_cast<std::size_t>(height / blockY) * static_cast<std::size_t>(channels));
+	mipmap_image(level, width, height, channels, next.data(), blockX, blockY);
+	std::swap(current, next);
+	level = current.data();
+	width /= blockX;
+	height /= blockY;
+  }
+  return texture;
+}
+
+TextureCache::TextureCache(fs::path dir, std::uintmax_t budget)
+  : directory{ std::move(dir) }, budgetBytes{ budget } {
+  std::error_code ec;
+  fs::create_directories(directory, ec);
+  if (ec)
+	std::cerr << "Could not create texture cache at " << directory << ": " << ec.message() << '\n';
+}
+
+std::optional<std::uint64_t> TextureCache::key(const fs::path& source) const {
+  std::error_code ec;
+  const auto modified = fs::last_write_time(source, ec);
+  if (ec)
+	return {};
+  auto absolute = fs::weakly_canonical(source, ec);
+  if (ec)
+	absolute = source;
+
+  const auto& name = absolute.native();
+  const auto key = hashBytes(name.data(), name.size(), cacheVersion);
+  return hashCombine(key, static_cast<std::uint64_t>(modified.time_since_epoch().count()));
+}
+
+fs::path TextureCache::entryPath(std::uint64_t key) const {
+  std::stringstream name;
+  name << std::hex << key << ".tex";
+  return directory / name.str();
+}
+
+std::optional<CompressedTexture> TextureCache::load(const fs::path& source) {
+  const auto sourceKey = key(source);
+  if (!sourceKey)
+	return {};
+
+  const auto path = entryPath(*sourceKey);
+  MappedFile file{ path };
+  if (!file || file.size() < sizeof(CacheHeader))
+	return {};
+
+  CacheHeader header;
+  std::memcpy(&header, file.data(), sizeof(header));
+  // bounded before the level table size is computed, which could wrap otherwise
+  if (header.magic != cacheMagic || header.version != cacheVersion || header.key != *sourceKey
+	  || (header.format != CompressedTexture::Format::Dxt1 && header.format != CompressedTexture::Format::Dxt5)
+	  || header.levels == 0 || header.levels > (file.size() - sizeof(CacheHeader)) / sizeof(CacheLevel)) {
+	std::cerr << "Ignoring corrupt cache entry " << path << '\n';
+	return {};
+  }
+  const auto dataStart = sizeof(CacheHeader) + header.levels * sizeof(CacheLevel);
+
+  // the levels are only described here, their blocks stay in the mapping until they are uploaded, so every level has to
+  // hold exactly the blocks glCompressedTexImage2D reads for its size
+  CompressedTexture texture;
+  texture.format = header.format;
+  const std::uint64_t blockBytes = header.format == CompressedTexture::Format::Dxt1 ? 8 : 16;
+  auto offset = dataStart;
+  for (std::uint64_t i = 0; i < header.levels; i++) {
+	CacheLevel level;
+	std::memcpy(&level, file.data() + sizeof(CacheHeader) + i * sizeof(CacheLevel), sizeof(level));
+	const auto valid = level.width >= 1 && level.height >= 1
+	  && (i == 0 || (level.width == std::max(texture.levels.back().width / 2, 1) && level.height == std::max(texture.levels.back().height / 2, 1)))
+	  && level.size == (static_cast<std::uint64_t>(level.width) + 3) / 4 * ((static_cast<std::uint64_t>(level.height) + 3) / 4) * blockBytes
+	  && level.size <= file.size() - offset;
+	if (!valid) {
+	  std::cerr << "Ignoring corrupt cache entry " << path << '\n';
+	  return {};
+	}
+	texture.levels.push_back({ level.width, level.height, offset, level.size });
+	offset += level.size;
+  }
+  if (offset != file.size()) {
+	std::cerr << "Ignoring corrupt cache entry " << path << '\n';
+	return {};
+  }
+  texture.file = std::move(file);
+
+  // the modification time doubles as the LRU timestamp
+  std::error_code ec;
+  fs::last_write_time(path, fs::file_time_type::clock::now(), ec);
+  return texture;
+}
+
+void TextureCache::store(const fs::path& source, const CompressedTexture& texture) {
+  const auto sourceKey = key(source);
+  if (!sourceKey || texture.levels.empty())
+	return;
+
+  writeCacheEntry(entryPath(*sourceKey), [&](std::ostream& out) {
+	const CacheHeader header{ cacheMagic, cacheVersion, texture.format, *sourceKey, texture.levels.size() };
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (const auto& level : texture.levels) {
+	  const CacheLevel entry{ level.width, level.height, level.size };
+	  out.write(reinterpret_cast<const char*>(&entry), sizeof(entry));
+	}
+	for (const auto& level : texture.levels)
+	  out.write(reinterpret_cast<const char*>(texture.data() + level.offset), static_cast<std::streamsize>(level.size));
+  });
+}
+
+TextureCache& defaultTextureCache() {
+  static TextureCache cache{ "cache/textures", 1ull << 30 };
+  return cache;
+}
+
+void TextureCache::evict() {
+  evictCacheEntries(directory, ".tex", budgetBytes);
+}
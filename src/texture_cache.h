@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <optional>
+#include <vector>
+
+#include "mapped_file.h"
+
+// Block compressed mip chain of a texture, either freshly compressed or mapped from the cache.
+struct CompressedTexture {
+  enum class Format : std::uint32_t { Dxt1, Dxt5 };
+
+  struct Level {
+	int width;
+	int height;
+	std::size_t offset;
+	std::size_t size;
+  };
+
+  Format format = Format::Dxt1;
+  std::vector<Level> levels;
+  // the blocks of every level, owned by storage unless they are read from a mapped cache entry
+  std::vector<std::byte> storage;
+  MappedFile file;
+
+  const std::byte* data() const { return file ? file.data() : storage.data(); }
+};
+
+// Compresses 8-bit pixels with 1 to 4 channels into a full mip chain, DXT1 for odd channel counts and DXT5 for the ones with alpha.
+CompressedTexture compressTexture(const unsigned char* pixels, int width, int height, int channels);
+
+// On-disk cache of compressed textures, keyed by the path and modification time of the source image.
+// Entries are stored as one file each and evicted least recently used first once the directory exceeds its budget.
+class TextureCache {
+ public:
+  TextureCache(std::filesystem::path directory, std::uintmax_t budgetBytes);
+
+  std::optional<CompressedTexture> load(const std::filesystem::path& source);
+  void store(const std::filesystem::path& source, const CompressedTexture& texture);
+  // separate from store so a batch of textures stored from several threads is only trimmed once
+  void evict();
+
+ private:
+  std::optional<std::uint64_t> key(const std::filesystem::path& source) const;
+  std::filesystem::path entryPath(std::uint64_t key) const;
+
+  std::filesystem::path directory;
+  std::uintmax_t budgetBytes;
+};
+
+// The cache the model loader uses when it is not given one, created on first use.
+TextureCache& defaultTextureCache();
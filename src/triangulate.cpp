@@ -9,7 +9,9 @@
 
 DelaunayTriangulation::DelaunayTriangulation() {
   for (int i = 0; i < INIT_VERTICES_COUNT; i++) {
+	// negative ids keep the auxiliary dots apart from the caller's dots
 	_AuxiliaryDots[i] = new Vector3D(
+	  -(i + 1),
 	  (i % 2 == 0 ? 1 : -1) * (i / 2 == 0 ? VECTOR_LENGTH : 0),
 	  (i % 2 == 0 ? 1 : -1) * (i / 2 == 1 ? VECTOR_LENGTH : 0),
 	  (i % 2 == 0 ? 1 : -1) * (i / 2 == 2 ? VECTOR_LENGTH : 0),
@@ -121,7 +123,7 @@ void DelaunayTriangulation::BuildInitialHull(std::vector<Vector3D*>* dots) {
 	Vector3D* v1 = initialVertices[vertex1Index[i]];
 	Vector3D* v2 = initialVertices[vertex2Index[i]];
 
-	Triangle* triangle = new Triangle(v0, v1, v2);
+	Triangle* triangle = new Triangle(m_nextTriangleId++, v0, v1, v2);
 	initialHullFaces[i] = triangle;
 
 	m_mesh->push_back(triangle);
@@ -209,8 +211,8 @@ void DelaunayTriangulation::RemoveExtraTriangles() {
 }
 
 void DelaunayTriangulation::SplitTriangle(Triangle* triangle, Vector3D* dot) {
-  Triangle* newTriangle1 = new Triangle(dot, triangle->Vertex[1], triangle->Vertex[2]);
-  Triangle* newTriangle2 = new Triangle(dot, triangle->Vertex[2], triangle->Vertex[0]);
+  Triangle* newTriangle1 = new Triangle(m_nextTriangleId++, dot, triangle->Vertex[1], triangle->Vertex[2]);
+  Triangle* newTriangle2 = new Triangle(m_nextTriangleId++, dot, triangle->Vertex[2], triangle->Vertex[0]);
 
   triangle->Vertex[2] = triangle->Vertex[1];
   triangle->Vertex[1] = triangle->Vertex[0];
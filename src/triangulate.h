@@ -13,6 +13,7 @@ class DelaunayTriangulation {
   Vector3D* _AuxiliaryDots[INIT_VERTICES_COUNT];
   std::vector<Vector3D*>* m_projectedDots;
   std::vector<Triangle*>* m_mesh;
+  int m_nextTriangleId = 0;
 
   // 0: triangle search operations
   // 1: local optimizations
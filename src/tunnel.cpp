@@ -0,0 +1,204 @@
+#include "tunnel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <numbers>
+
+#include "delaunay2d.h"
+
+using namespace glm;
+
+// eigenvector of the largest eigenvalue of a symmetric 3x3 matrix, using cyclic jacobi rotations
+dvec3 principalAxis(double a[3][3]) {
+  double v[3][3] = { { 1, 0, 0 }, { 0, 1, 0 }, { 0, 0, 1 } };
+  for (auto sweep = 0; sweep < 32; sweep++) {
+	const auto off = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+	const auto diag = a[0][0] * a[0][0] + a[1][1] * a[1][1] + a[2][2] * a[2][2];
+	if (off <= 1e-24 * diag) break;
+	for (const auto& [p, q] : { std::pair{ 0, 1 }, std::pair{ 0, 2 }, std::pair{ 1, 2 } }) {
+	  if (a[p][q] == 0) continue;
+	  const auto theta = (a[q][q] - a[p][p]) / (2 * a[p][q]);
+	  const auto t = (theta >= 0 ? 1.0 : -1.0) / (std::abs(theta) + std::sqrt(theta * theta + 1));
+	  const auto c = 1 / std::sqrt(t * t + 1);
+	  const auto s = t * c;
+	  for (auto k = 0; k < 3; k++) {
+		const auto akp = a[k][p];
+		const auto akq = a[k][q];
+		a[k][p] = c * akp - s * akq;
+		a[k][q] = s * akp + c * akq;
+	  }
+	  for (auto k = 0; k < 3; k++) {
+		const auto apk = a[p][k];
+		const auto aqk = a[q][k];
+		a[p][k] = c * apk - s * aqk;
+		a[q][k] = s * apk + c * aqk;
+	  }
+	  for (auto k = 0; k < 3; k++) {
+		const auto vkp = v[k][p];
+		const auto vkq = v[k][q];
+		v[k][p] = c * vkp - s * vkq;
+		v[k][q] = s * vkp + c * vkq;
+	  }
+	}
+  }
+
+  auto largest = 0;
+  for (auto i = 1; i < 3; i++)
+	if (a[i][i] > a[largest][largest]) largest = i;
+  return { v[0][largest], v[1][largest], v[2][largest] };
+}
+
+// any two unit vectors completing direction to an orthonormal basis
+std::pair<dvec3, dvec3> orthonormalBasis(dvec3 direction) {
+  const auto helper = std::abs(direction.x) < 0.9 ? dvec3{ 1, 0, 0 } : dvec3{ 0, 1, 0 };
+  const auto u = normalize(cross(direction, helper));
+  return { u, cross(direction, u) };
+}
+
+TunnelAxis fitTunnelAxis(const std::vector<Point>& points) {
+  dvec3 centroid{};
+  for (const auto& p : points)
+	centroid += dvec3{ p.pos };
+  centroid /= static_cast<double>(points.size());
+
+  double covariance[3][3] = {};
+  for (const auto& p : points) {
+	const auto d = dvec3{ p.pos } - centroid;
+	for (auto i = 0; i < 3; i++)
+	  for (auto j = 0; j < 3; j++)
+		covariance[i][j] += d[i] * d[j];
+  }
+  const auto direction = normalize(principalAxis(covariance));
+
+  // Kasa circle fit x^2 + y^2 + Dx + Ey + F = 0 in the cross-section plane. Unlike the centroid this also finds the
+  // axis of a horseshoe profile where the floor was not scanned.
+  const auto [u, v] = orthonormalBasis(direction);
+  double m[3][3] = {};
+  double rhs[3] = {};
+  for (const auto& p : points) {
+	const auto d = dvec3{ p.pos } - centroid;
+	const double row[3] = { dot(d, u), dot(d, v), 1.0 };
+	const auto z = -(row[0] * row[0] + row[1] * row[1]);
+	for (auto i = 0; i < 3; i++) {
+	  for (auto j = 0; j < 3; j++)
+		m[i][j] += row[i] * row[j];
+	  rhs[i] += row[i] * z;
+	}
+  }
+  const auto det = [](const double a[3][3]) {
+	return a[0][0] * (a[1][1] * a[2][2] - a[1][2] * a[2][1]) - a[0][1] * (a[1][0] * a[2][2] - a[1][2] * a[2][0])
+		   + a[0][2] * (a[1][0] * a[2][1] - a[1][1] * a[2][0]);
+  };
+  auto origin = centroid;
+  const auto denominator = det(m);
+  if (std::abs(denominator) > 1e-12) {
+	double solution[2];
+	for (auto k = 0; k < 2; k++) {
+	  double replaced[3][3];
+	  for (auto i = 0; i < 3; i++)
+		for (auto j = 0; j < 3; j++)
+		  replaced[i][j] = j == k ? rhs[i] : m[i][j];
+	  solution[k] = det(replaced) / denominator;
+	}
+	origin += u * (-solution[0] / 2) + v * (-solution[1] / 2);
+  }
+
+  return { vec3{ origin }, vec3{ direction } };
+}
+
+std::vector<Triangle> reconstructTunnel(const std::vector<Point>& points, const TunnelOptions& options) {
+  if (points.size() < 3)
+	return {};
+
+  const auto axis = options.axis ? options.axis.value() : fitTunnelAxis(points);
+  const auto direction = normalize(dvec3{ axis.direction });
+  const auto origin = dvec3{ axis.origin };
+  const auto [u, v] = orthonormalBasis(direction);
+
+  std::vector<double> along(points.size());
+  std::vector<double> angle(points.size());
+  auto meanRadius = 0.0;
+  auto minAlong = std::numeric_limits<double>::max();
+  auto maxAlong = std::numeric_limits<double>::lowest();
+  for (std::size_t i = 0; i < points.size(); i++) {
+	const auto d = dvec3{ points[i].pos } - origin;
+	along[i] = dot(d, direction);
+	const auto x = dot(d, u);
+	const auto y = dot(d, v);
+	angle[i] = std::atan2(y, x);
+	meanRadius += std::sqrt(x * x + y * y);
+	minAlong = std::min(minAlong, along[i]);
+	maxAlong = std::max(maxAlong, along[i]);
+  }
+  meanRadius = std::max(meanRadius / static_cast<double>(points.size()), 1e-9);
+
+  constexpr auto pi = std::numbers::pi;
+  const auto spacing = std::sqrt((maxAlong - minAlong) * 2 * pi * meanRadius / static_cast<double>(points.size()));
+  const auto maxEdge = options.maxEdgeLength > 0 ? static_cast<double>(options.maxEdgeLength) : 4 * spacing;
+
+  // Scaling the angle by the radius turns it into arc length, so the unrolled points keep their 3D spacing. Points near
+  // the seam are duplicated on the other side so the triangulation wraps around.
+  const auto seamBand = std::min(pi / 4, 2 * maxEdge / meanRadius);
+  std::vector<dvec2> unrolled;
+  std::vector<std::uint32_t> source;
+  unrolled.reserve(points.size() + points.size() / 8);
+  source.reserve(unrolled.capacity());
+  for (std::size_t i = 0; i < points.size(); i++) {
+	unrolled.push_back({ along[i], angle[i] * meanRadius });
+	source.push_back(static_cast<std::uint32_t>(i));
+  }
+  for (std::size_t i = 0; i < points.size(); i++) {
+	if (angle[i] > pi - seamBand) {
+	  unrolled.push_back({ along[i], (angle[i] - 2 * pi) * meanRadius });
+	  source.push_back(static_cast<std::uint32_t>(i));
+	} else if (angle[i] < -pi + seamBand) {
+	  unrolled.push_back({ along[i], (angle[i] + 2 * pi) * meanRadius });
+	  source.push_back(static_cast<std::uint32_t>(i));
+	}
+  }
+
+  const auto triangulation = delaunay2d(unrolled);
+
+  std::vector<Triangle> triangles;
+  triangles.reserve(triangulation.size());
+  auto orientation = 0.0f;
+  for (const auto& t : triangulation) {
+	// of the two copies of a triangle across the seam keep the one centered in [-pi, pi)
+	const auto centerAngle = (unrolled[t[0]].y + unrolled[t[1]].y + unrolled[t[2]].y) / (3 * meanRadius);
+	if (centerAngle < -pi || centerAngle >= pi)
+	  continue;
+
+	const auto& a = points[source[t[0]]];
+	const auto& b = points[source[t[1]]];
+	const auto& c = points[source[t[2]]];
+	if (&a == &b || &b == &c || &a == &c)
+	  continue;
+	const auto maxEdge2 = static_cast<float>(maxEdge * maxEdge);
+	if (length2(a.pos - b.pos) > maxEdge2 || length2(b.pos - c.pos) > maxEdge2 || length2(c.pos - a.pos) > maxEdge2)
+	  continue;
+
+	const Triangle triangle{ a.pos, b.pos, c.pos };
+	orientation += dot(cross(b.pos - a.pos, c.pos - a.pos), a.normal + b.normal + c.normal);
+	triangles.push_back(triangle);
+  }
+
+  // the unrolled triangulation is consistently oriented, flip all of it if it disagrees with the point normals
+  if (orientation < 0)
+	for (auto& t : triangles)
+	  std::swap(t[1], t[2]);
+
+  return triangles;
+}
+
+std::vector<Triangle> measuredReconstructTunnel(const std::vector<Point>& points, const TunnelOptions& options) {
+  const auto start = std::chrono::high_resolution_clock::now();
+  auto result = reconstructTunnel(points, options);
+  const auto end = std::chrono::high_resolution_clock::now();
+  const auto seconds = std::chrono::duration_cast<std::chrono::duration<double>>(end - start).count();
+  std::cerr << "[  TUNNEL  ] Point: " << points.size() << " Triangles: " << result.size() << " T/s: " << result.size() / seconds << '\n';
+  return result;
+}
@@ -0,0 +1,29 @@
+#pragma once
+
+#include <optional>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "bpa.h"
+
+struct TunnelAxis {
+  glm::vec3 origin;
+  glm::vec3 direction;
+};
+
+struct TunnelOptions {
+  // fitted from the cloud when not given
+  std::optional<TunnelAxis> axis;
+  // triangles with a longer edge are dropped as holes, 0 derives it from the average point spacing
+  float maxEdgeLength = 0.0f;
+};
+
+// Fits the axis of a roughly cylindrical scan. The direction is the principal component of the points, so the scanned
+// section has to be longer than it is wide, and the origin is the center of a circle fitted to the cross-section.
+TunnelAxis fitTunnelAxis(const std::vector<Point>& points);
+
+// Reconstruction specialised for tunnels: unrolls the points around the axis into (length along the axis, arc length)
+// coordinates, triangulates them with a planar Delaunay triangulation and lifts the result back onto the input points.
+std::vector<Triangle> reconstructTunnel(const std::vector<Point>& points, const TunnelOptions& options = {});
+std::vector<Triangle> measuredReconstructTunnel(const std::vector<Point>& points, const TunnelOptions& options = {});
@@ -16,20 +16,33 @@ void key_callback(GLFWwindow* window, int key, int scancode, int action, int mod
 constexpr unsigned int SCREEN_WIDTH = 1920;
 constexpr unsigned int SCREEN_HEIGHT = 1080;
 
-float lastX = (float)SCREEN_WIDTH / 2.0;
-float lastY = (float)SCREEN_WIDTH / 2.0;
-bool firstMouse = true;
-Camera camera(glm::vec3(0.0f, 0.0f, 5.0f));
-
 class Window {
 
  public:
-  Window(unsigned int width, unsigned int height) {
+  // An invisible window only provides the context, for the headless benchmarks that render into an OffscreenTarget. The
+  // context then comes from EGL, and from OSMesa without any display where GLFW has the null platform (3.4).
+  Window(unsigned int width, unsigned int height, bool visible = true) {
+#ifdef GLFW_PLATFORM_NULL
+	if (!visible && !std::getenv("DISPLAY") && !std::getenv("WAYLAND_DISPLAY"))
+	  glfwInitHint(GLFW_PLATFORM, GLFW_PLATFORM_NULL);
+#endif
 	glfwInit();
+	if (!visible) {
+	  glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef GLFW_PLATFORM_NULL
+	  const auto api = glfwGetPlatform() == GLFW_PLATFORM_NULL ? GLFW_OSMESA_CONTEXT_API : GLFW_EGL_CONTEXT_API;
+	  glfwWindowHint(GLFW_CONTEXT_CREATION_API, api);
+#else
+	  glfwWindowHint(GLFW_CONTEXT_CREATION_API, GLFW_EGL_CONTEXT_API);
+#endif
+	}
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 4);
 	glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 4);
 	glfwWindowHint(GLFW_OPENGL_DEBUG_CONTEXT, true);
 	glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+	// the depth format of the G-buffer, which the deferred lighting pass blits into this framebuffer
+	glfwWindowHint(GLFW_DEPTH_BITS, 24);
+	glfwWindowHint(GLFW_STENCIL_BITS, 8);
 
 	windowHandle = glfwCreateWindow(width, height, "Proyecto 2", nullptr, nullptr);
 	if (windowHandle == nullptr) {
@@ -46,7 +59,8 @@ class Window {
 	glfwSetScrollCallback(windowHandle, scroll_callback);
 	glfwSetKeyCallback(windowHandle, key_callback);
 
-	glfwSetInputMode(windowHandle, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+	if (visible)
+	  glfwSetInputMode(windowHandle, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
   }
 
   GLFWwindow* handle() { return windowHandle; }
@@ -84,8 +98,18 @@ class Window {
   bool wireframe = false;
   bool renderMesh = true;
   bool renderPoints = false;
+  // large clouds are drawn decimated until the full cloud is asked for
+  bool previewPoints = true;
   bool renderLights = true;
   bool refresh = false;
+  // applied to the ball radius when the reconstruction is restarted with refresh
+  float radiusScale = 1.0f;
+
+  // input state lives in the window, the callbacks find it through the glfw user pointer
+  Camera camera{ glm::vec3(0.0f, 0.0f, 5.0f) };
+  float lastX = (float)SCREEN_WIDTH / 2.0;
+  float lastY = (float)SCREEN_WIDTH / 2.0;
+  bool firstMouse = true;
 
  private:
   GLFWwindow* windowHandle;
@@ -97,25 +121,31 @@ inline void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 }
 
 inline void mouse_callback(GLFWwindow* window, double xposIn, double yposIn) {
+  auto* handler = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+  if (!handler)
+	return;
+
   float xpos = static_cast<float>(xposIn);
   float ypos = static_cast<float>(yposIn);
-  if (firstMouse) {
-	lastX = xpos;
-	lastY = ypos;
-	firstMouse = false;
+  if (handler->firstMouse) {
+	handler->lastX = xpos;
+	handler->lastY = ypos;
+	handler->firstMouse = false;
   }
 
-  float xoffset = xpos - lastX;
-  float yoffset = lastY - ypos;
+  float xoffset = xpos - handler->lastX;
+  float yoffset = handler->lastY - ypos;
 
-  lastX = xpos;
-  lastY = ypos;
+  handler->lastX = xpos;
+  handler->lastY = ypos;
 
-  camera.ProcessMouseMovement(xoffset, yoffset);
+  handler->camera.ProcessMouseMovement(xoffset, yoffset);
 }
 
 inline void scroll_callback(GLFWwindow* window, double xoffset, double yoffset) {
-  camera.ProcessMouseScroll(static_cast<float>(yoffset));
+  auto* handler = reinterpret_cast<Window*>(glfwGetWindowUserPointer(window));
+  if (handler)
+	handler->camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
 inline void key_callback(GLFWwindow* window, int key, int scancode, int action, int mods) {
@@ -128,6 +158,9 @@ inline void key_callback(GLFWwindow* window, int key, int scancode, int action,
 	if (key == GLFW_KEY_P && action == GLFW_RELEASE) {
 	  handler->renderPoints = !(handler->renderPoints);
 	}
+	if (key == GLFW_KEY_V && action == GLFW_RELEASE) {
+	  handler->previewPoints = !(handler->previewPoints);
+	}
 	if (key == GLFW_KEY_M && action == GLFW_RELEASE) {
 	  handler->renderMesh = !(handler->renderMesh);
 	}
@@ -137,5 +170,11 @@ inline void key_callback(GLFWwindow* window, int key, int scancode, int action,
 	if (key == GLFW_KEY_R && action == GLFW_RELEASE) {
 	  handler->refresh = !(handler->refresh);
 	}
+	if (key == GLFW_KEY_LEFT_BRACKET && action == GLFW_RELEASE) {
+	  handler->radiusScale /= 1.25f;
+	}
+	if (key == GLFW_KEY_RIGHT_BRACKET && action == GLFW_RELEASE) {
+	  handler->radiusScale *= 1.25f;
+	}
   }
 }
@@ -0,0 +1,90 @@
+#include <cstdlib>
+#include <iostream>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/gtc/matrix_transform.hpp>
+
+#include "lod.h"
+
+namespace {
+
+int failures = 0;
+
+void check(bool condition, const char* what) {
+  if (!condition) {
+	std::cerr << "FAILED: " << what << '\n';
+	failures++;
+  }
+}
+
+// Flat strip in the xz plane along +z, one unit wide and `length` units long, with quadsPerUnit^2 quads per square unit.
+std::vector<Triangle> makeStrip(int length, int quadsPerUnit) {
+  std::vector<Triangle> strip;
+  const auto step = 1.0f / static_cast<float>(quadsPerUnit);
+  for (int i = 0; i < length * quadsPerUnit; i++) {
+	for (int j = 0; j < quadsPerUnit; j++) {
+	  const auto x = static_cast<float>(j) * step - 0.5f;
+	  const auto z = static_cast<float>(i) * step;
+	  const glm::vec3 a{ x, 0.0f, z };
+	  const glm::vec3 b{ x + step, 0.0f, z };
+	  const glm::vec3 c{ x + step, 0.0f, z + step };
+	  const glm::vec3 d{ x, 0.0f, z + step };
+	  strip.push_back({ a, b, c });
+	  strip.push_back({ a, c, d });
+	}
+  }
+  return strip;
+}
+
+glm::mat4 viewProjection(glm::vec3 eye, glm::vec3 target) {
+  return glm::perspective(glm::radians(60.0f), 16.0f / 9.0f, 0.1f, 100.0f) * glm::lookAt(eye, target, glm::vec3{ 0.0f, 1.0f, 0.0f });
+}
+
+} // namespace
+
+int main() {
+  constexpr int tiles = 32;
+  const LodMesh lod{ makeStrip(tiles, 8), { glm::vec3{ 0.0f }, glm::vec3{ 0.0f, 0.0f, 1.0f } }, { 1.0f, 3, 2.0f } };
+  check(lod.tiles().size() == tiles, "one tile per unit of the strip");
+  for (const auto& tile : lod.tiles())
+	check(tile.levels.size() == 3, "every tile has all levels");
+
+  // looking down the strip from just before its start, every tile is in view
+  {
+	const glm::vec3 eye{ 0.0f, 0.5f, -1.0f };
+	const auto selection = lod.select(eye, viewProjection(eye, { 0.0f, 0.0f, 16.0f }));
+	check(selection.size() == tiles, "all tiles ahead are selected");
+	check(!selection.empty() && selection.front().tile == 0 && selection.front().level == 0, "nearest tile first, at full detail");
+	for (std::size_t i = 1; i < selection.size(); i++)
+	  check(selection[i - 1].level <= selection[i].level, "detail drops with distance");
+	for (const auto& s : selection) {
+	  // the nearest point of tile i is about i + 1 units away: full detail below 2 units, one level per doubling after
+	  const auto distance = static_cast<float>(s.tile) + 1.0f;
+	  const auto expected = distance < 2.0f ? 0u : (distance < 4.0f ? 1u : 2u);
+	  if (std::abs(distance - 2.0f) > 0.1f && std::abs(distance - 4.0f) > 0.1f)
+		check(s.level == expected, "level follows the distance to the eye");
+	}
+  }
+
+  // from the middle of the strip looking ahead, the tiles behind the eye are rejected
+  {
+	const glm::vec3 eye{ 0.0f, 0.5f, 16.5f };
+	const auto selection = lod.select(eye, viewProjection(eye, { 0.0f, 0.0f, 32.0f }));
+	check(!selection.empty(), "the tiles ahead are selected");
+	for (const auto& s : selection)
+	  check(s.tile >= 15, "tiles behind the eye are culled");
+	check(selection.size() < tiles, "part of the strip is culled");
+  }
+
+  // looking away from the strip, nothing is drawn
+  {
+	const glm::vec3 eye{ 0.0f, 0.5f, -1.0f };
+	check(lod.select(eye, viewProjection(eye, { 0.0f, 0.0f, -10.0f })).empty(), "a strip behind the eye is culled");
+  }
+
+  if (failures > 0)
+	return EXIT_FAILURE;
+  std::cout << "lod_test passed\n";
+  return EXIT_SUCCESS;
+}